@@ -0,0 +1,178 @@
+/*
+ * ArenaBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures what building and freeing an unfrozen graph costs. Random
+ * collaborations between artists picked uniformly are inserted with
+ * insert_vertex and insert_edge, each named by its own song, and it
+ * counts the heap allocations and times:
+ *   1) building the graph, one artist and collaboration at a time
+ *   2) destroying the graph, before it is ever frozen
+ * Allocations are counted by replacing the global operator new, aligned
+ * or not, so they include the blocks of the graph's arena as well as
+ * everything allocated outside it. A "make STATS=1" build counts them
+ * with Stats' replacement instead.
+ *
+ * Usage: ArenaBench [artists] [collaborations]
+ *
+ */
+
+#include "Artist.h"
+#include "CollabGraph.h"
+#include "Stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+#ifdef SIXDEGREES_STATS
+
+// Stats already replaces operator new to count allocations
+static size_t allocations() {
+    return Stats::total(Stats::ALLOCATIONS);
+}
+
+#else
+
+// Every allocation made through the global operator new, aligned or not
+static atomic<size_t> numAllocations(0);
+
+static size_t allocations() {
+    return numAllocations;
+}
+
+void *operator new(size_t size) {
+    numAllocations++;
+    void *allocated = malloc(size == 0 ? 1 : size);
+    if (allocated == nullptr) {
+        throw bad_alloc();
+    }
+    return allocated;
+}
+
+void operator delete(void *allocated) noexcept {
+    free(allocated);
+}
+
+void operator delete(void *allocated, size_t) noexcept {
+    free(allocated);
+}
+
+// The arena's blocks come from std::pmr::new_delete_resource, which
+// allocates them with these
+void *operator new(size_t size, align_val_t alignment) {
+    numAllocations++;
+    size_t bytes = static_cast<size_t>(alignment);
+    void *allocated = nullptr;
+    if (posix_memalign(&allocated, bytes < sizeof(void *) ? sizeof(void *)
+                                                         : bytes,
+                       size == 0 ? 1 : size) != 0) {
+        throw bad_alloc();
+    }
+    return allocated;
+}
+
+void *operator new(size_t size, align_val_t alignment,
+                   const nothrow_t &) noexcept {
+    try {
+        return operator new(size, alignment);
+    }
+    catch (const bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *allocated, align_val_t) noexcept {
+    free(allocated);
+}
+
+void operator delete(void *allocated, size_t, align_val_t) noexcept {
+    free(allocated);
+}
+
+void operator delete(void *allocated, align_val_t,
+                     const nothrow_t &) noexcept {
+    free(allocated);
+}
+
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t numArtists = argc > 1 ? atol(argv[1]) : 200000;
+    size_t numCollabs = argc > 2 ? atol(argv[2]) : 1000000;
+
+    if (argc > 3 or numArtists < 2) {
+        cerr << "Usage: ArenaBench [artists] [collaborations]\n";
+        return EXIT_FAILURE;
+    }
+
+    mt19937 random(15);
+    vector<Artist> artists;
+    for (size_t i = 0; i < numArtists; i++) {
+        artists.push_back(Artist("Artist " + to_string(i)));
+    }
+
+    // The songs are made before the build, so only the graph's own
+    // allocations are counted
+    vector<size_t> firsts, seconds;
+    vector<string> songs;
+    for (size_t c = 0; c < numCollabs; c++) {
+        firsts.push_back(random() % numArtists);
+        seconds.push_back(random() % numArtists);
+        songs.push_back("Song " + to_string(c));
+    }
+
+    size_t before = allocations();
+    Clock::time_point start = Clock::now();
+    optional<CollabGraph> graph(in_place);
+    for (const Artist &artist : artists) {
+        graph->insert_vertex(artist);
+    }
+
+    // Loops are not collaborations, and a pair picked twice keeps the
+    // song it was given first
+    for (size_t c = 0; c < numCollabs; c++) {
+        if (firsts[c] != seconds[c]) {
+            graph->insert_edge(artists[firsts[c]], artists[seconds[c]],
+                               songs[c]);
+        }
+    }
+    double buildMs = milliseconds(start);
+    size_t buildAllocations = allocations() - before;
+
+    start = Clock::now();
+    graph.reset();
+    double destroyMs = milliseconds(start);
+
+    cout << "graph: " << numArtists << " artists, " << numCollabs
+         << " collaborations inserted\n"
+         << "allocations: " << buildAllocations << "\n"
+         << "build:       " << buildMs << " ms\n"
+         << "destroy:     " << destroyMs << " ms\n";
+
+    return EXIT_SUCCESS;
+}
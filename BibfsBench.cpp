@@ -0,0 +1,135 @@
+/*
+ * BibfsBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures how much of the graph bibfs searches compared with bfs. On one
+ * data file, such as one written by GraphGen, the same random pairs of
+ * different artists are answered with bfs and with bibfs, and for each
+ * command it prints the mean number of artists a query reached (queued,
+ * from either end) and the mean time of a query. The lengths of the paths
+ * found both ways are compared, since both are shortest paths though not
+ * always the same ones.
+ *
+ * Usage: BibfsBench dataFile [queries] [seed]
+ *
+ */
+
+#include "CollabGraph.h"
+#include "SixDegrees.h"
+#include "TraversalEngine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: answer
+ * @purpose: answers every query with one command, counting the artists
+ *           each one reached and the lines of its output
+ *
+ * @parameters: the engine, the command, the queries, where to store each
+ *              query's number of output lines, and where to store the mean
+ *              time of a query in milliseconds
+ * @returns: the mean number of artists a query reached
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double answer(TraversalEngine &engine, const string &command,
+                     vector<Query> &queries, vector<size_t> &lines,
+                     double &ms) {
+    ostringstream output;
+    double reached = 0;
+    ms = 0;
+
+    for (size_t q = 0; q < queries.size(); q++) {
+        queries[q].command = command;
+        output.str("");
+
+        Clock::time_point start = Clock::now();
+        engine.run(queries[q], output);
+        ms += milliseconds(start);
+        reached += engine.verticesReached();
+
+        lines[q] = 0;
+        for (char c : output.str()) {
+            lines[q] += (c == '\n');
+        }
+    }
+    ms /= queries.size();
+    return reached / queries.size();
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 or argc > 4) {
+        cerr << "Usage: BibfsBench dataFile [queries] [seed]\n";
+        return EXIT_FAILURE;
+    }
+    size_t numQueries = argc > 2 ? atol(argv[2]) : 200;
+    unsigned seed     = argc > 3 ? atol(argv[3]) : 15;
+
+    SixDegrees program(2, argv);
+    CollabGraph &graph = program.load();
+
+    size_t numArtists = graph.vertex_count();
+    if (numArtists < 2 or numQueries == 0) {
+        cerr << argv[1] << " does not have two artists to query.\n";
+        return EXIT_FAILURE;
+    }
+
+    // Landmarks would cut bfs short, so it would not search as bfs does
+    if (graph.landmark_count() > 0) {
+        cerr << argv[1] << " has landmarks; give the data file instead.\n";
+        return EXIT_FAILURE;
+    }
+
+    mt19937_64 random(seed);
+    vector<Query> queries(numQueries);
+    for (Query &query : queries) {
+        CollabGraph::VertexId source = random() % numArtists;
+        CollabGraph::VertexId dest   = random() % numArtists;
+        while (dest == source) {
+            dest = random() % numArtists;
+        }
+        query.source = string(graph.get_vertex_name(source));
+        query.dest   = string(graph.get_vertex_name(dest));
+    }
+
+    TraversalEngine engine(graph);
+    vector<size_t> bfsLines(numQueries), bibfsLines(numQueries);
+    double bfsMs, bibfsMs;
+    double bfsReached   = answer(engine, "bfs", queries, bfsLines, bfsMs);
+    double bibfsReached = answer(engine, "bibfs", queries, bibfsLines,
+                                 bibfsMs);
+
+    cout << "graph: " << numArtists << " artists, "
+         << graph.adjacency_size() / 2 << " collaborations, " << numQueries
+         << " queries\n"
+         << "bfs:          " << bfsReached << " artists reached, " << bfsMs
+         << " ms per query\n"
+         << "bibfs:        " << bibfsReached << " artists reached, "
+         << bibfsMs << " ms per query\n"
+         << "same lengths: " << (bfsLines == bibfsLines ? "yes" : "no")
+         << "\n";
+
+    return EXIT_SUCCESS;
+}
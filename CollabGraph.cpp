@@ -32,19 +32,126 @@
  **/
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <exception>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <numeric>
 #include <stack>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 
 #include "Artist.h"
 #include "CollabGraph.h"
+#include "Stats.h"
 
 using namespace std;
 
+const CollabGraph::VertexId CollabGraph::NO_VERTEX;
+const uint32_t              CollabGraph::NO_BOUND;
+const uint32_t              CollabGraph::NO_CHANGE;
+
+/* 64-bit FNV-1a, used for the name index and snapshot checksums because,
+ * unlike std::hash, it is the same in every build
+ */
+static uint64_t fnv1a(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* Run task(thread, 0) .. task(thread, num_tasks - 1) on num_threads
+ * threads, each of which takes the next unstarted task until none are left
+ */
+static void run_tasks(unsigned num_threads, size_t num_tasks,
+                      const function<void(unsigned, size_t)>& task) {
+    atomic<size_t> next(0);
+    vector<thread> threads;
+
+    for (unsigned t = 0; t < num_threads; t++) {
+        threads.push_back(thread([&, t]() {
+            for (size_t i = next++; i < num_tasks; i = next++) task(t, i);
+            STATS_FLUSH();
+        }));
+    }
+    for (thread& worker : threads) worker.join();
+}
+
+/* Whether offsets[0 .. count] start at 0 and never decrease, so that each
+ * range [offsets[i], offsets[i + 1]) ends within offsets[count]
+ */
+static bool ascending(const uint64_t* offsets, size_t count) {
+    if (offsets[0] != 0) return false;
+    for (size_t i = 0; i < count; i++) {
+        if (offsets[i + 1] < offsets[i]) return false;
+    }
+    return true;
+}
+
+/* Whether every id in ids[0 .. count) is below limit, or, in a hash index,
+ * is below limit or the mark of an empty bucket
+ */
+template <typename Id>
+static bool in_range(const Id* ids, size_t count, size_t limit) {
+    for (size_t i = 0; i < count; i++) {
+        if (ids[i] >= limit) return false;
+    }
+    return true;
+}
+
+template <typename Id>
+static bool in_range(const Id* ids, size_t count, size_t limit, Id empty) {
+    for (size_t i = 0; i < count; i++) {
+        if (ids[i] >= limit and ids[i] != empty) return false;
+    }
+    return true;
+}
+
+/* Snapshot identification */
+static const char     SNAPSHOT_MAGIC[8]   = {'S', 'I', 'X', 'D', 'E', 'G',
+                                             'S', '\0'};
+static const uint32_t SNAPSHOT_VERSION    = 4;
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+/* Returned by find_slot when there is no edge */
+static const size_t NO_SLOT = SIZE_MAX;
+
+/* Marks an empty bucket of the catalog index, and a song not in it */
+static const uint32_t NO_SONG = UINT32_MAX;
+
+/* A landmark distance is one byte: the number of hops, LANDMARK_FAR for
+ * LANDMARK_FAR hops or more, or LANDMARK_UNREACHED if there is no path
+ */
+static const uint8_t LANDMARK_FAR       = 254;
+static const uint8_t LANDMARK_UNREACHED = 255;
+
+/* Every print_graph line, but for the names and the song, is
+ *     "name" collaborated with "neighbor" in "song".
+ * and the line of a vertex's last neighbor is followed by an empty line
+ */
+static const string_view PRINT_WITH = "\" collaborated with \"";
+static const string_view PRINT_IN   = "\" in \"";
+static const string_view PRINT_END  = "\".\n";
+
+/* print_graph formats the lines of at least this many edges (or the whole
+ * graph) in each task, and writes its tasks' text before starting more
+ */
+static const size_t PRINT_CHUNK = 1 << 14;
+
 /*********************************************************************
  ******************** public function definitions ********************
  *********************************************************************/
@@ -96,41 +203,97 @@ CollabGraph::CollabGraph(const CollabGraph& source) {
  *
  * @parameters: a const CollabGraph reference, to be deeply copied
  * @returns: a CollabGraph reference
+ *
+ * @notes: 1) the unfrozen graph is copied in O(V + E), one vertex at a
+ *            time in id order, so every neighbor list keeps its order
+ *         2) a frozen image is never written, so the copy shares it rather
+ *            than copying it, and only the updates made since it was built
+ *            or loaded, and the metadata, are copied. Neither graph can
+ *            change the other: add_artist and add_song only change the
+ *            updates, and build_landmarks builds a new image
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 CollabGraph& CollabGraph::operator=(const CollabGraph& rhs) {
     if (this == &rhs) return *this;
 
     self_destruct();
 
-    /* ITERATING OVER AN UNORDERED_MAP:
-     * An unordered map is made up of (key, value) pairs, of type std::pair.
-     * We use a std::iterator to iterate over the entire map, which starts
-     * out as the result of the unordered_map begin() function.
-     *
-     * Declaring iterator types in C++ is pretty complicated, so this is
-     * the one case in which our course style guide allows for the use of
-     * the "auto" keyword.
-     */
+    if (rhs.unfrozen != nullptr) copy_vertices(*rhs.unfrozen);
+    build_stats = rhs.build_stats;
 
-    /* first, insert the new vertices, one per artist
-       this is necessary so the neighbors / predecessors will exist in 'this'
-       graph
-    */
-    for (auto itr = rhs.graph.begin(); itr != graph.end(); itr++) {
-        this->insert_vertex(itr->second->artist);
+    if (rhs.frozen) {
+        image = rhs.image;
+        attach(rhs.image_base, rhs.image_size, false);
+        num_landmarks = rhs.num_landmarks;
     }
+    copy_updates(rhs);
+    metadata = rhs.metadata;
 
-    /* now, add the adjacency lists and prev pointers */
-    for (auto itr = rhs.graph.begin(); itr != graph.end(); itr++) {
+    return *this;
+}
 
-        Artist curr_artist = graph[itr->first]->artist;
 
-        for (const Edge& edge : itr->second->neighbors) {
-            this->insert_edge(curr_artist, edge.neighbor->artist, edge.song);
-        }
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: move constructor
+ * @purpose: take another CollabGraph instance's graph without copying it
+ *
+ * @preconditions: none
+ * @postconditions: this instance has the graph the provided CollabGraph
+ *                  had, and the provided CollabGraph is empty
+ *
+ * @parameters: a CollabGraph rvalue reference, to be moved from
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::CollabGraph(CollabGraph&& source) noexcept {
+    *this = std::move(source);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: move assignment operator overload
+ * @purpose: free this graph and take another CollabGraph instance's graph
+ *           without copying it
+ *
+ * @parameters: a CollabGraph rvalue reference, to be moved from, which is
+ *              left empty
+ * @returns: a CollabGraph reference
+ *
+ * @notes: 1) only pointers change hands: the unfrozen graph is on the
+ *            heap, the image is shared, and the containers of updates keep
+ *            their elements where they are, so the views into added_names
+ *            and added_songs stay valid
+ *         2) nothing is allocated, unlike in self_destruct: this graph's
+ *            updates are freed by being moved over, and moving leaves
+ *            rhs's containers empty
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph& CollabGraph::operator=(CollabGraph&& rhs) noexcept {
+    if (this == &rhs) return *this;
+
+    free_vertices();
+    detach();
 
-        this->set_predecessor(curr_artist, itr->second->predecessor->artist);
+    unfrozen    = std::move(rhs.unfrozen);
+    build_stats = rhs.build_stats;
+
+    if (rhs.frozen) {
+        image = std::move(rhs.image);
+        attach(rhs.image_base, rhs.image_size, false);
+        num_landmarks = rhs.num_landmarks;
     }
+    added_names    = std::move(rhs.added_names);
+    added_ids      = std::move(rhs.added_ids);
+    changed        = std::move(rhs.changed);
+    changed_lists  = std::move(rhs.changed_lists);
+    added_songs    = std::move(rhs.added_songs);
+    added_song_ids = std::move(rhs.added_song_ids);
+    added_postings = std::move(rhs.added_postings);
+    added_slots    = rhs.added_slots;
+    next_position  = rhs.next_position;
+    metadata       = std::move(rhs.metadata);
+
+    rhs.detach();
+    rhs.metadata      = SearchState();
+    rhs.added_slots   = 0;
+    rhs.next_position = UINT64_C(1) << 32;
+    rhs.build_stats   = BuildStats();
 
     return *this;
 }
@@ -146,6 +309,8 @@ CollabGraph& CollabGraph::operator=(const CollabGraph& rhs) {
  * @returns: none
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void CollabGraph::populate_graph(const vector<Artist>& artists) {
+    STATS_TIMER(BUILD);
+
     // Create a vertex in the CollabGraph for each Artist
     for(size_t i = 0; i < artists.size(); i++) {
         insert_vertex(artists.at(i));
@@ -162,6 +327,499 @@ void CollabGraph::populate_graph(const vector<Artist>& artists) {
     }
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: populate_graph
+ * @purpose: based on a vector of artists and their discographies, build the
+ *           graph using a song -> artists inverted index, so that only
+ *           artists who actually share a song are ever compared
+ *
+ * @parameters: 1) a const vector<Artist>& from which to build the graph
+ *              2) a const vector of song lists, where songs.at(i) holds the
+ *                 songs of artists.at(i) in the order they were added
+ * @preconditions: the graph is empty, and both vectors have the same size
+ *
+ * @postconditions: the graph is populated based on the provided artists,
+ *                  with exactly the edges and edge names the pairwise
+ *                  populate_graph would produce, and build_stats is updated
+ * @returns: none
+ *
+ * @notes: 1) runs in O(total song occurrences + edges log(degree)) instead
+ *            of O(artists^2)
+ *         2) like Artist::get_collaboration, the name of an edge between
+ *            artists i < j is the first song in artist i's discography that
+ *            artist j also has, and edges are inserted in (i, j) order so
+ *            the adjacency lists match the pairwise build exactly
+ *         3) throws a runtime_error if the vectors differ in size
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::populate_graph(const vector<Artist>& artists,
+                                 const vector<vector<string>>& songs) {
+    STATS_TIMER(BUILD);
+
+    if (artists.size() != songs.size()) {
+        string message = "every artist needs exactly one song list";
+        throw runtime_error(message.c_str());
+    }
+
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    build_stats = BuildStats();
+    build_stats.artists = artists.size();
+
+    for (size_t i = 0; i < artists.size(); i++) {
+        insert_vertex(artists.at(i));
+    }
+
+    // Map every song to the (ascending) indices of the artists that have it
+    unordered_map<string, vector<size_t>> song_index;
+    for (size_t i = 0; i < songs.size(); i++) {
+        for (const string& song : songs.at(i)) {
+            vector<size_t>& posting = song_index[song];
+            if (posting.empty() or posting.back() != i) posting.push_back(i);
+            build_stats.song_occurrences++;
+        }
+    }
+    build_stats.distinct_songs = song_index.size();
+
+    Clock::time_point indexed = Clock::now();
+
+    /* For each artist i, walk its songs in order and claim every later
+     * artist j found in a song's posting list. The first song that claims
+     * j is the first shared song, so later songs never relabel the edge.
+     */
+    vector<size_t>        claimed_by(artists.size(), artists.size());
+    vector<const string*> label(artists.size(), nullptr);
+    vector<size_t>        partners;
+
+    for (size_t i = 0; i < artists.size(); i++) {
+        partners.clear();
+
+        for (const string& song : songs.at(i)) {
+            const vector<size_t>& posting = song_index.at(song);
+            auto j = upper_bound(posting.begin(), posting.end(), i);
+            for (; j != posting.end(); j++) {
+                build_stats.postings_scanned++;
+                if (claimed_by[*j] != i) {
+                    claimed_by[*j] = i;
+                    label[*j]      = &song;
+                    partners.push_back(*j);
+                }
+            }
+        }
+
+        sort(partners.begin(), partners.end());
+
+        for (size_t j : partners) {
+            // An empty first shared song means "no collaboration" as before
+            if (*label[j] != "") {
+                insert_edge(artists.at(i), artists.at(j), *label[j]);
+                build_stats.edges++;
+            }
+        }
+    }
+
+    Clock::time_point done = Clock::now();
+    build_stats.index_ms =
+        chrono::duration<double, milli>(indexed - start).count();
+    build_stats.edges_ms =
+        chrono::duration<double, milli>(done - indexed).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: populate_graph
+ * @purpose: build the frozen graph from a parsed data file, on several
+ *           threads
+ *
+ * @parameters: 1) the pieces of the data file, in file order; artists are
+ *                 numbered in this order
+ *              2) the number of threads to use
+ * @preconditions: the graph is empty, and the text the chunks refer to
+ *                 stays valid until this returns
+ *
+ * @postconditions: the graph is frozen, with exactly the vertices, edges
+ *                  and edge names the other populate_graph functions (or
+ *                  a Builder) would give, and build_stats is updated
+ * @returns: none
+ *
+ * @notes: 1) works in four phases, each split into independent tasks:
+ *            a) each chunk files its names and song occurrences into
+ *               buckets by hash, one bucket per chunk and partition
+ *            b) each partition gives its songs ids and posting lists,
+ *               reading its buckets in chunk order so every posting list
+ *               is in ascending artist order
+ *            c) each block of artists finds its edges to later artists,
+ *               like the indexed populate_graph, into its own buffer
+ *            d) the buffers are merged, in artist order, into the image
+ *         2) throws a runtime_error if an artist's name is empty or
+ *            repeated
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::populate_graph(const vector<Records>& chunks,
+                                 unsigned               num_threads) {
+    STATS_TIMER(BUILD);
+
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    // An index into a chunk's names or songs, and the artist it belongs to
+    struct Occurrence {
+        uint32_t index;
+        VertexId artist;
+    };
+
+    // An edge to a later artist, named by song id
+    struct Collab {
+        VertexId partner;
+        uint32_t song;
+    };
+
+    const uint32_t DUPLICATE = UINT32_MAX;
+
+    num_threads = max(num_threads, 1u);
+
+    vector<VertexId> first_artist(chunks.size() + 1, 0);
+    for (size_t c = 0; c < chunks.size(); c++) {
+        if (chunks[c].songs.size() >= UINT32_MAX) {
+            throw runtime_error("a chunk of the data file is too large");
+        }
+        first_artist[c + 1] = first_artist[c] + chunks[c].names.size();
+    }
+    VertexId num_artists = first_artist.back();
+
+    build_stats         = BuildStats();
+    build_stats.artists = num_artists;
+
+    size_t num_parts = 1;
+    while (num_parts < 4 * num_threads) num_parts *= 2;
+
+    // a) File every name and song occurrence under its hash partition
+    vector<vector<Occurrence>> name_buckets(chunks.size() * num_parts);
+    vector<vector<Occurrence>> song_buckets(chunks.size() * num_parts);
+    vector<vector<uint32_t>>   song_of(chunks.size());
+
+    run_tasks(num_threads, chunks.size(), [&](unsigned, size_t c) {
+        const Records& chunk   = chunks[c];
+        size_t         buckets = c * num_parts;
+
+        song_of[c].resize(chunk.songs.size());
+        for (uint32_t a = 0; a < chunk.names.size(); a++) {
+            VertexId    artist = first_artist[c] + a;
+            string_view name   = chunk.names[a];
+            uint64_t    hash   = fnv1a(name.data(), name.size());
+            name_buckets[buckets + (hash & (num_parts - 1))].push_back(
+                {a, artist});
+
+            for (uint64_t k = chunk.song_offsets[a];
+                 k < chunk.song_offsets[a + 1]; k++) {
+                string_view song = chunk.songs[k];
+                hash             = fnv1a(song.data(), song.size());
+                song_buckets[buckets + (hash & (num_parts - 1))].push_back(
+                    {(uint32_t) k, artist});
+            }
+        }
+    });
+
+    // b) Check each partition's names, and index its songs
+    vector<vector<string_view>>      part_songs(num_parts);
+    vector<vector<vector<VertexId>>> part_postings(num_parts);
+    vector<vector<vector<uint32_t>>> part_positions(num_parts);
+    vector<VertexId>                 part_error(num_parts, NO_VERTEX);
+
+    run_tasks(num_threads, num_parts, [&](unsigned, size_t p) {
+        unordered_set<string_view>           names;
+        unordered_map<string_view, uint32_t> ids;
+
+        for (size_t c = 0; c < chunks.size(); c++) {
+            for (const Occurrence& name : name_buckets[c * num_parts + p]) {
+                string_view view = chunks[c].names[name.index];
+                if (view.empty() or not names.insert(view).second) {
+                    part_error[p] = min(part_error[p], name.artist);
+                }
+            }
+            vector<Occurrence>().swap(name_buckets[c * num_parts + p]);
+
+            for (const Occurrence& song : song_buckets[c * num_parts + p]) {
+                uint32_t next_song = part_songs[p].size();
+                auto     id        = ids.insert(
+                    {chunks[c].songs[song.index], next_song});
+                if (id.second) {
+                    part_songs[p].push_back(chunks[c].songs[song.index]);
+                    part_postings[p].push_back(vector<VertexId>());
+                    part_positions[p].push_back(vector<uint32_t>());
+                }
+
+                // Only the first time an artist lists a song can name an edge
+                vector<VertexId>& posting = part_postings[p][id.first->second];
+                if (not posting.empty() and posting.back() == song.artist) {
+                    song_of[c][song.index] = DUPLICATE;
+                } else {
+                    uint64_t first = chunks[c].song_offsets[song.artist -
+                                                            first_artist[c]];
+                    posting.push_back(song.artist);
+                    part_positions[p][id.first->second].push_back(song.index -
+                                                                  first);
+                    song_of[c][song.index] = id.first->second;
+                }
+            }
+        }
+    });
+
+    VertexId error = *min_element(part_error.begin(), part_error.end());
+    if (error != NO_VERTEX) {
+        size_t c = upper_bound(first_artist.begin(), first_artist.end(),
+                               error) -
+                   first_artist.begin() - 1;
+        string_view name = chunks[c].names[error - first_artist[c]];
+        string      message =
+            name.empty() ? "cannot insert an improperly initialized "
+                           "Artist instance (name must be non-empty)"
+                         : "artist \"" + string(name) +
+                               "\" appears more than once in the data";
+        throw runtime_error(message.c_str());
+    }
+
+    // Each partition's songs take the next range of global song ids
+    vector<uint32_t> first_song(num_parts + 1, 0);
+    for (size_t p = 0; p < num_parts; p++) {
+        first_song[p + 1] = first_song[p] + part_songs[p].size();
+    }
+
+    vector<string_view>             song_names(first_song.back());
+    vector<const vector<VertexId>*> postings(first_song.back());
+    vector<const vector<uint32_t>*> positions(first_song.back());
+
+    run_tasks(num_threads, num_parts, [&](unsigned, size_t p) {
+        for (uint32_t local = 0; local < part_songs[p].size(); local++) {
+            song_names[first_song[p] + local] = part_songs[p][local];
+            postings[first_song[p] + local]   = &part_postings[p][local];
+            positions[first_song[p] + local]  = &part_positions[p][local];
+        }
+        for (size_t c = 0; c < chunks.size(); c++) {
+            for (const Occurrence& song : song_buckets[c * num_parts + p]) {
+                uint32_t& id = song_of[c][song.index];
+                if (id != DUPLICATE) id += first_song[p];
+            }
+            vector<Occurrence>().swap(song_buckets[c * num_parts + p]);
+        }
+    });
+
+    build_stats.distinct_songs = song_names.size();
+    for (const Records& chunk : chunks) {
+        build_stats.song_occurrences += chunk.songs.size();
+    }
+
+    Clock::time_point indexed = Clock::now();
+
+    // c) Find every artist's edges to later artists, a block at a time
+    const uint32_t BLOCK_SIZE = 4096;
+
+    struct Block {
+        size_t           chunk;
+        uint32_t         first, last;
+        vector<uint32_t> degrees;
+        vector<Collab>   collabs;
+    };
+    vector<Block> blocks;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        for (uint32_t a = 0; a < chunks[c].names.size(); a += BLOCK_SIZE) {
+            uint32_t last = min<size_t>(a + BLOCK_SIZE, chunks[c].names.size());
+            blocks.push_back({c, a, last, {}, {}});
+        }
+    }
+
+    vector<vector<VertexId>> claimed_by(num_threads), label(num_threads);
+    vector<vector<VertexId>> partners(num_threads);
+    vector<size_t>           scanned(num_threads, 0);
+
+    run_tasks(num_threads, blocks.size(), [&](unsigned t, size_t b) {
+        Block&         block = blocks[b];
+        const Records& chunk = chunks[block.chunk];
+
+        if (claimed_by[t].empty()) {
+            claimed_by[t].assign(num_artists, NO_VERTEX);
+            label[t].resize(num_artists);
+        }
+
+        for (uint32_t a = block.first; a < block.last; a++) {
+            VertexId i = first_artist[block.chunk] + a;
+            partners[t].clear();
+
+            for (uint64_t k = chunk.song_offsets[a];
+                 k < chunk.song_offsets[a + 1]; k++) {
+                uint32_t id = song_of[block.chunk][k];
+                if (id == DUPLICATE) continue;
+
+                const vector<VertexId>& posting = *postings[id];
+                auto j = upper_bound(posting.begin(), posting.end(), i);
+                for (; j != posting.end(); j++) {
+                    scanned[t]++;
+                    if (claimed_by[t][*j] != i) {
+                        claimed_by[t][*j] = i;
+                        label[t][*j]      = id;
+                        partners[t].push_back(*j);
+                    }
+                }
+            }
+
+            sort(partners[t].begin(), partners[t].end());
+
+            uint32_t degree = 0;
+            for (VertexId j : partners[t]) {
+                // An empty first shared song means "no collaboration"
+                if (not song_names[label[t][j]].empty()) {
+                    block.collabs.push_back({j, label[t][j]});
+                    degree++;
+                }
+            }
+            block.degrees.push_back(degree);
+        }
+    });
+
+    vector<vector<VertexId>>().swap(claimed_by);
+    vector<vector<VertexId>>().swap(label);
+    for (size_t t = 0; t < num_threads; t++) {
+        build_stats.postings_scanned += scanned[t];
+    }
+
+    // d) Merge the blocks into the image, in artist order
+    vector<bool> used(song_names.size(), false);
+    uint64_t     num_songs = 0, song_bytes = 0;
+
+    for (const Block& block : blocks) {
+        build_stats.edges += block.collabs.size();
+        for (const Collab& collab : block.collabs) {
+            if (not used[collab.song]) {
+                used[collab.song] = true;
+                num_songs++;
+                song_bytes += song_names[collab.song].size();
+            }
+        }
+    }
+    vector<bool>().swap(used);
+
+    uint64_t name_bytes = 0;
+    for (const Records& chunk : chunks) {
+        for (string_view name : chunk.names) name_bytes += name.size();
+    }
+
+    // The catalog lists songs in the order the data first lists them, the
+    // order Builder numbers them in, so both build the same image
+    vector<uint32_t> order;
+    vector<bool>     listed(song_names.size(), false);
+    uint64_t         catalog_bytes = 0, num_postings = 0;
+
+    order.reserve(song_names.size());
+    for (size_t c = 0; c < chunks.size(); c++) {
+        for (uint32_t id : song_of[c]) {
+            if (id != DUPLICATE and not listed[id]) {
+                listed[id] = true;
+                order.push_back(id);
+                catalog_bytes += song_names[id].size();
+                num_postings += postings[id]->size();
+            }
+        }
+        vector<uint32_t>().swap(song_of[c]);
+    }
+    vector<bool>().swap(listed);
+
+    self_destruct();
+
+    SnapshotHeader header = SnapshotHeader();
+    header.num_vertices   = num_artists;
+    header.num_slots      = 2 * build_stats.edges;
+    header.num_songs      = num_songs;
+    header.name_bytes     = name_bytes;
+    header.song_bytes     = song_bytes;
+    header.catalog_songs  = order.size();
+    header.catalog_bytes  = catalog_bytes;
+    header.num_postings   = num_postings;
+
+    uint64_t at[NUM_SECTIONS];
+    char*    base = allocate_image(header, at);
+
+    write_catalog_names(base, at, song_names, order);
+
+    uint64_t* new_posting_offsets =
+        reinterpret_cast<uint64_t*>(base + at[12]);
+    VertexId* new_posting_artists =
+        reinterpret_cast<VertexId*>(base + at[13]);
+    uint32_t* new_posting_positions =
+        reinterpret_cast<uint32_t*>(base + at[14]);
+    for (uint32_t c = 0; c < order.size(); c++) {
+        const vector<VertexId>& posting = *postings[order[c]];
+        uint64_t                first   = new_posting_offsets[c];
+        memcpy(new_posting_artists + first, posting.data(),
+               posting.size() * sizeof(VertexId));
+        memcpy(new_posting_positions + first, positions[order[c]]->data(),
+               posting.size() * sizeof(uint32_t));
+        new_posting_offsets[c + 1] = first + posting.size();
+    }
+    vector<uint32_t>().swap(order);
+    vector<vector<vector<VertexId>>>().swap(part_postings);
+    vector<vector<vector<uint32_t>>>().swap(part_positions);
+
+    uint64_t* new_offsets      = reinterpret_cast<uint64_t*>(base + at[0]);
+    VertexId* new_adjacency    = reinterpret_cast<VertexId*>(base + at[1]);
+    uint32_t* new_songs        = reinterpret_cast<uint32_t*>(base + at[2]);
+    uint64_t* new_name_offsets = reinterpret_cast<uint64_t*>(base + at[3]);
+    char*     new_name_chars   = base + at[6];
+
+    for (const Block& block : blocks) {
+        VertexId i = first_artist[block.chunk] + block.first;
+        for (uint32_t degree : block.degrees) new_offsets[1 + i++] += degree;
+        for (const Collab& collab : block.collabs) {
+            new_offsets[collab.partner + 1]++;
+        }
+    }
+    for (VertexId v = 0; v < num_artists; v++) {
+        new_offsets[v + 1] += new_offsets[v];
+    }
+
+    /* An artist's edges to earlier artists are all filled in before its
+     * edges to later ones, each in ascending order, which is the order
+     * populate_graph inserts them in
+     */
+    vector<uint64_t> next_slot(new_offsets, new_offsets + num_artists);
+    for (Block& block : blocks) {
+        VertexId i = first_artist[block.chunk] + block.first;
+        size_t   c = 0;
+
+        for (uint32_t degree : block.degrees) {
+            for (uint32_t e = 0; e < degree; e++, c++) {
+                VertexId j      = block.collabs[c].partner;
+                uint64_t mine   = next_slot[i]++;
+                uint64_t theirs = next_slot[j]++;
+
+                new_adjacency[mine]   = j;
+                new_songs[mine]       = block.collabs[c].song;
+                new_adjacency[theirs] = i;
+                new_songs[theirs]     = block.collabs[c].song;
+            }
+            i++;
+        }
+        vector<Collab>().swap(block.collabs);
+    }
+    vector<uint64_t>().swap(next_slot);
+
+    VertexId v = 0;
+    for (const Records& chunk : chunks) {
+        for (string_view name : chunk.names) {
+            memcpy(new_name_chars + new_name_offsets[v], name.data(),
+                   name.size());
+            new_name_offsets[v + 1] = new_name_offsets[v] + name.size();
+            v++;
+        }
+    }
+
+    write_song_table(base, at, header.num_slots, song_names);
+    seal_image(header, at);
+
+    Clock::time_point done = Clock::now();
+    build_stats.index_ms =
+        chrono::duration<double, milli>(indexed - start).count();
+    build_stats.edges_ms =
+        chrono::duration<double, milli>(done - indexed).count();
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * @function: insert_vertex
  * @purpose: insert a vertex in the collaboration graph
@@ -172,9 +830,14 @@ void CollabGraph::populate_graph(const vector<Artist>& artists) {
  * @notes: 1) if the artist is already in the graph, then nothing happens
  *         2) throws a runtime_error iff the provided Artist has the empty
  *            string as its name, since an Artist instance with the empty
- *            string as its name is improperly initialized
+ *            string as its name is improperly initialized, or if the graph
+ *            is frozen
+ *         3) vertices are numbered in insertion order; freeze() keeps
+ *            these numbers as their VertexIds
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void CollabGraph::insert_vertex(const Artist& artist) {
+    enforce_mutable();
+
     if (artist.get_name() == "") {
         string message = "cannot insert an improperly initialized "
                          "Artist instance (name must be non-empty)";
@@ -191,10 +854,15 @@ void CollabGraph::insert_vertex(const Artist& artist) {
      * track of predecessors simpler.
      */
     if (not is_vertex(artist)) {
-        Vertex* vertex = new Vertex(artist);
+        if (unfrozen == nullptr) unfrozen = make_unique<UnfrozenGraph>();
+
+        pmr::monotonic_buffer_resource& arena = unfrozen->arena;
+        void*   memory = arena.allocate(sizeof(Vertex), alignof(Vertex));
+        Vertex* vertex = new (memory) Vertex(artist, &arena);
+        vertex->id     = unfrozen->graph.size();
         /* these curly braces make an initializer list for the pair struct
          */
-        graph.insert({artist.get_name(), vertex});
+        unfrozen->graph.insert({arena_copy(artist.get_name()), vertex});
     }
 }
 
@@ -224,19 +892,21 @@ void CollabGraph::insert_vertex(const Artist& artist) {
  *            2) 'a1' and 'a2' are the same vertex, because creating an edge
  *               between a vertex and itself would
  *               product a loop (which would very likely result in an
- *               infinite loop during traversal)
+ *               infinite loop during traversal) OR,
+ *            3) the graph is frozen
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void CollabGraph::insert_edge(const Artist& a1, const Artist& a2,
                               const string& edgeName) {
-    enforce_valid_vertex(a1);
-    enforce_valid_vertex(a2);
+    enforce_mutable();
+    Vertex* v1 = find_vertex(a1);
+    Vertex* v2 = find_vertex(a2);
 
     if (edgeName == "") {
         string message = "the empty string is not a valid edge name";
         throw runtime_error(message.c_str());
     }
 
-    if (a1 == a2) {
+    if (v1 == v2) {
         string message = "cannot insert an edge between a "
                          "vertex and itself";
         throw runtime_error(message.c_str());
@@ -245,14 +915,15 @@ void CollabGraph::insert_edge(const Artist& a1, const Artist& a2,
     /* Do not insert an edge between a1 and a2 if there
      * is already an edge that connects them.
      */
-    if (get_edge(a1, a2) != "") return;
-
-
-    vector<Edge>& a1_neighbors = graph[a1.get_name()]->neighbors;
-    vector<Edge>& a2_neighbors = graph[a2.get_name()]->neighbors;
-
-    a1_neighbors.push_back(Edge(graph[a2.get_name()], edgeName));
-    a2_neighbors.push_back(Edge(graph[a1.get_name()], edgeName));
+    const Vertex* lower = v1->id < v2->id ? v1 : v2;
+    auto edge = unfrozen->edge_index.insert(
+        {edge_key(v1, v2), lower->neighbors.size()});
+    if (not edge.second) return;
+
+    // Both directions share one copy of the song
+    string_view song = arena_copy(edgeName);
+    v1->neighbors.push_back(Edge(v2, song));
+    v2->neighbors.push_back(Edge(v1, song));
 }
 
 
@@ -266,8 +937,12 @@ void CollabGraph::insert_edge(const Artist& a1, const Artist& a2,
  * @returns:    none
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void CollabGraph::mark_vertex(const Artist& artist) {
-    enforce_valid_vertex(artist);
-    graph[artist.get_name()]->visited = true;
+    if (frozen) {
+        mark_vertex(frozen_id(artist));
+        return;
+    }
+
+    find_vertex(artist)->visited = true;
 }
 
 
@@ -280,8 +955,12 @@ void CollabGraph::mark_vertex(const Artist& artist) {
  * @returns:    none
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void CollabGraph::unmark_vertex(const Artist& artist) {
-    enforce_valid_vertex(artist);
-    graph[artist.get_name()]->visited = false;
+    if (frozen) {
+        frozen_metadata().unmark_vertex(frozen_id(artist));
+        return;
+    }
+
+    find_vertex(artist)->visited = false;
 }
 
 
@@ -301,11 +980,13 @@ void CollabGraph::unmark_vertex(const Artist& artist) {
  *             'from' (predecessor) vertex to the 'to' vertex
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void CollabGraph::set_predecessor(const Artist& to, const Artist& from) {
-    enforce_valid_vertex(to);
-    enforce_valid_vertex(from);
+    if (frozen) {
+        set_predecessor(frozen_id(to), frozen_id(from));
+        return;
+    }
 
-    Vertex* vertex      = graph[to.get_name()];
-    Vertex* pred_vertex = graph[from.get_name()];
+    Vertex* vertex      = find_vertex(to);
+    Vertex* pred_vertex = find_vertex(from);
 
     /* It is a mistake to set the predecessor of a vertex if it
      * already has one.
@@ -327,13 +1008,24 @@ void CollabGraph::set_predecessor(const Artist& to, const Artist& from) {
  *
  * @warning: this function MUST be called before each traversal, and failure
  *           to heed this warning will result in undefined behavior
+ * @notes: O(1) on a frozen graph, O(V) otherwise
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void CollabGraph::clear_metadata() {
+    STATS_TIMER(CLEAR);
+
+    // A frozen graph only has to start a new epoch (see SearchState::clear)
+    if (frozen) {
+        metadata.clear(vertex_count());
+        return;
+    }
+    if (unfrozen == nullptr) return;
+
     /* Again, we use the std::iterator to iterate over an unordered_map.
      * Whereas the graph.at() function returns just the "value", when we
      * iterate we're getting the (key, value) pairs, so we have to
      * traverse to the second element in the pair to get the vertex itself.
      */
+    const auto& graph = unfrozen->graph;
     for (auto itr = graph.begin(); itr != graph.end(); itr++) {
         itr->second->visited     = false;
         itr->second->predecessor = nullptr;
@@ -350,7 +1042,10 @@ void CollabGraph::clear_metadata() {
  * @returns: a bool, true iff the provided artist is in the graph
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 bool CollabGraph::is_vertex(const Artist& artist) const {
-    return graph.find(artist.get_name()) != graph.end();
+    if (frozen) return get_vertex_id(artist.get_name()) != NO_VERTEX;
+    if (unfrozen == nullptr) return false;
+
+    return unfrozen->graph.count(artist.get_name()) != 0;
 }
 
 
@@ -362,8 +1057,9 @@ bool CollabGraph::is_vertex(const Artist& artist) const {
  * @returns: a bool, true iff the provided vertex has been visited
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 bool CollabGraph::is_marked(const Artist& artist) const {
-    enforce_valid_vertex(artist);
-    return graph.at(artist.get_name())->visited;
+    if (frozen) return is_marked(frozen_id(artist));
+
+    return find_vertex(artist)->visited;
 }
 
 
@@ -378,14 +1074,19 @@ bool CollabGraph::is_marked(const Artist& artist) const {
  *           empty string as the name if the given artist has no predecessor
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 Artist CollabGraph::get_predecessor(const Artist& artist) const {
-    enforce_valid_vertex(artist);
-
     /* An artist with the empty string as its name represents a
      * non-existent artist */
     Artist pred_artist;
 
+    if (frozen) {
+        VertexId pred = get_predecessor(frozen_id(artist));
+        if (pred != NO_VERTEX) {
+            pred_artist = Artist(string(get_vertex_name(pred)));
+        }
+        return pred_artist;
+    }
 
-    Vertex* pred_vertex = graph.at(artist.get_name())->predecessor;
+    Vertex* pred_vertex = find_vertex(artist)->predecessor;
 
     if (pred_vertex) pred_artist = pred_vertex->artist;
 
@@ -405,16 +1106,13 @@ Artist CollabGraph::get_predecessor(const Artist& artist) const {
  *             'a2', or the empty string if there is no edge connecting them
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 string CollabGraph::get_edge(const Artist& a1, const Artist& a2) const {
-    enforce_valid_vertex(a1);
-    enforce_valid_vertex(a2);
+    if (frozen) return get_edge(frozen_id(a1), frozen_id(a2));
 
-    vector<Edge> edges = graph.at(a1.get_name())->neighbors;
+    const Edge* edge = find_edge(find_vertex(a1), find_vertex(a2));
 
-    for (const Edge& edge : edges) {
-        if (edge.neighbor->artist == a2) return edge.song;
-    }
+    if (edge == nullptr) return "";
 
-    return "";
+    return string(edge->song);
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -428,10 +1126,17 @@ string CollabGraph::get_edge(const Artist& a1, const Artist& a2) const {
 vector<Artist> CollabGraph::get_vertex_neighbors(const Artist& artist) const {
     vector<Artist> neighbors;
 
-    enforce_valid_vertex(artist);
-    
-    // Create a vector for all of the vertex's edges 
-    vector<Edge> edges = graph.at(artist.get_name())->neighbors;
+    if (frozen) {
+        VertexId vertex = frozen_id(artist);
+        for (const VertexId* n = neighbors_begin(vertex);
+             n != neighbors_end(vertex); n++) {
+            neighbors.push_back(Artist(string(get_vertex_name(*n))));
+        }
+        return neighbors;
+    }
+
+    // Look at all of the vertex's edges 
+    const pmr::vector<Edge>& edges = find_vertex(artist)->neighbors;
     for (size_t i = 0; i < edges.size(); i++) {
         // Add each Artist connected to the edges to the neighbor vector
         neighbors.push_back(edges.at(i).neighbor->artist);
@@ -464,110 +1169,2640 @@ stack<Artist> CollabGraph::report_path(const Artist& source,
     stack<Artist> path;
     stack<Artist> empty;
 
-    enforce_valid_vertex(source);
-    enforce_valid_vertex(dest);
+    // Follow ids (or vertices), so each name is only looked up once
+    if (frozen) {
+        VertexId from = frozen_id(source);
+        VertexId curr = frozen_id(dest);
+
+        if (from == curr) return empty;
+
+        path.push(Artist(string(get_vertex_name(curr))));
+        while (curr != from) {
+            curr = get_predecessor(curr);
+            if (curr == NO_VERTEX) return empty;
+            path.push(Artist(string(get_vertex_name(curr))));
+        }
+        return path;
+    }
+
+    Vertex* from = find_vertex(source);
+    Vertex* curr = find_vertex(dest);
     
     // There are not at least 2 elements for the path to oneself, so invalid
-    if (source == dest) {
+    if (from == curr) {
         return empty;
     }
     
     // Start from the destination
-    Artist curr = dest;
-    path.push(curr);
+    path.push(curr->artist);
     
     // Iterate by predecessor until we reach the source of the path
-    while (curr != source) {
-        path.push(get_predecessor(curr));
-        curr = get_predecessor(curr);
+    while (curr != from) {
+        curr = curr->predecessor;
         // If there's no predecessor there is no path so return an empty stack
-        if (curr.get_name() == "") {
+        if (curr == nullptr) {
             return empty;
         }
+        path.push(curr->artist);
     }
     
     return path;
 }
 
 
-/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * function: print_graph
  * purpose: print a representation of the information stored in the
  *          collaboration graph IN SORTED ORDER
  *
  * parameters: a ostream reference, where output is sent
  * returns: none
- * NOTES:   Prints the graph in sorted order!
+ * NOTES:   the same as print_graph(out, 1)
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void CollabGraph::print_graph(ostream& out) {
-    vector<string> output;
-
-    string quote = "\"";
+void CollabGraph::print_graph(ostream& out) const {
+    print_graph(out, 1);
+}
 
-    for (auto itr = graph.begin(); itr != graph.end(); itr++) {
 
-        /* It is always the case that the edges and neighbors
-         * vectors have the same number of elements
-         */
-        vector<Edge> neighbors = itr->second->neighbors;
-        for (size_t i = 0; i < neighbors.size(); i++) {
-            string s = quote + itr->second->artist.get_name() + quote + " " +
-                       "collaborated with " + quote +
-                       neighbors.at(i).neighbor->artist.get_name() + quote +
-                       " in " + quote + neighbors.at(i).song + quote + ".\n";
-            if (i == neighbors.size() - 1) s += '\n';
-            output.push_back(s);
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * function: print_graph
+ * purpose: print a representation of the information stored in the
+ *          collaboration graph IN SORTED ORDER
+ *
+ * parameters: 1) a ostream reference, where output is sent
+ *             2) the number of threads to sort and format on
+ * returns: none
+ * NOTES:   Prints the graph in sorted order! Each line is the same as
+ *          before, sorted as strings and without the very last newline,
+ *          but the lines are never all built at once: the vertices are
+ *          sorted by name, and then the lines of a few vertices at a time
+ *          are sorted, formatted (on num_threads threads) and written
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::print_graph(ostream& out, unsigned num_threads) const {
+    STATS_TIMER(OUTPUT);
+
+    PrintSource source;
+    size_t      num = vertex_count();
+    if (unfrozen != nullptr) {
+        source.vertices.resize(num);
+        source.names.resize(num);
+
+        const auto& graph = unfrozen->graph;
+        for (auto itr = graph.begin(); itr != graph.end(); itr++) {
+            source.vertices[itr->second->id] = itr->second;
+            source.names[itr->second->id]    = itr->first;
         }
     }
 
-    // if empty graph, don't print
-    if (output.empty()) { return; }
+    num_threads = max(num_threads, 1u);
+    auto tasks  = [&](size_t num_tasks,
+                      const function<void(unsigned, size_t)>& task) {
+        if (num_threads == 1) {
+            for (size_t i = 0; i < num_tasks; i++) task(0, i);
+        } else {
+            run_tasks(num_threads, num_tasks, task);
+        }
+    };
+
+    /* Every line of a vertex begins with its name and PRINT_WITH, so the
+     * vertices are put in that order: in runs, one per thread, which are
+     * then merged in pairs
+     */
+    vector<VertexId> order(num);
+    iota(order.begin(), order.end(), 0);
+    auto by_name = [&](VertexId v1, VertexId v2) {
+        JoinedText a = {{print_name(source, v1), PRINT_WITH}, 2};
+        JoinedText b = {{print_name(source, v2), PRINT_WITH}, 2};
+        int        c = compare_joined(a, b, 0);
+        return c < 0 or (c == 0 and joined_size(a, 0) < joined_size(b, 0));
+    };
+    size_t runs = min<size_t>(num_threads, num / PRINT_CHUNK + 1);
+    auto   run  = [&](size_t r) { return order.begin() + num * r / runs; };
+    tasks(runs, [&](unsigned, size_t r) {
+        sort(run(r), run(r + 1), by_name);
+    });
+    for (size_t width = 1; width < runs; width *= 2) {
+        // A last run without a partner is merged in a later round
+        tasks((runs - width - 1) / (2 * width) + 1, [&](unsigned, size_t p) {
+            size_t r = 2 * width * p;
+            inplace_merge(run(r), run(r + width),
+                          run(min(r + 2 * width, runs)), by_name);
+        });
+    }
 
-    // sort output to add clarity and autograding ease
-    sort(output.begin(), output.end());
+    vector<string> texts(num_threads);
+    bool           newline = false; // the last newline written is held back
+    for (size_t next = 0; next < num;) {
+        // One chunk of whole groups (see print_group) for each thread
+        vector<size_t> bounds(1, next);
+        while (bounds.size() <= num_threads and next < num) {
+            for (size_t lines = 0; next < num and lines < PRINT_CHUNK;) {
+                size_t group = print_group(source, &order[next],
+                                           order.data() + num);
+                for (size_t i = next; i < next + group; i++) {
+                    lines += print_degree(source, order[i]);
+                }
+                next += group;
+            }
+            bounds.push_back(next);
+        }
 
-    for (string& s : output) {
-        if (s == output[output.size() - 1]) { s = s.substr(0, s.size() - 1); }
-        out << s;
+        tasks(bounds.size() - 1, [&](unsigned, size_t c) {
+            texts[c].clear();
+            print_lines(source, order.data() + bounds[c],
+                        order.data() + bounds[c + 1], texts[c]);
+        });
+        for (size_t c = 0; c + 1 < bounds.size(); c++) {
+            if (texts[c].empty()) continue;
+            if (newline) out << '\n';
+            out.write(texts[c].data(), texts[c].size() - 1);
+            newline = true;
+        }
     }
 }
 
 
-/**********************************************************************
- ******************** private function definitions ********************
- **********************************************************************/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_build_stats
+ * @purpose: retrieve the statistics recorded by the last indexed
+ *           populate_graph call
+ *
+ * @parameters: none
+ * @returns: a const reference to the BuildStats of this graph
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+const CollabGraph::BuildStats& CollabGraph::get_build_stats() const {
+    return build_stats;
+}
 
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: self_destruct
- * @purpose: free all memory associated with this CollabGraph instance
+ * @function: print_build_stats
+ * @purpose: print the statistics recorded by the last indexed
+ *           populate_graph call, one "key: value" pair per line
  *
- * @parameters: none
+ * @parameters: a ostream reference, where output is sent
  * @returns: none
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void CollabGraph::self_destruct() {
-    for (auto itr = graph.begin(); itr != graph.end(); itr++) {
-        delete itr->second;
+void CollabGraph::print_build_stats(ostream& out) const {
+    out << "artists: "          << build_stats.artists          << "\n"
+        << "song occurrences: " << build_stats.song_occurrences << "\n"
+        << "distinct songs: "   << build_stats.distinct_songs   << "\n"
+        << "postings scanned: " << build_stats.postings_scanned << "\n"
+        << "edges: "            << build_stats.edges            << "\n"
+        << "index time (ms): "  << build_stats.index_ms         << "\n"
+        << "edge time (ms): "   << build_stats.edges_ms         << "\n";
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: memory_footprint
+ * @purpose: estimate the number of bytes used by the graph's structure, in
+ *           whichever layout it currently uses
+ *
+ * @parameters: none
+ * @returns: a size_t, the estimated size of the graph in bytes
+ *
+ * @notes: counts container storage, map nodes and out-of-line string
+ *         buffers; the contents of each vertex's Artist beyond the Artist
+ *         object itself are not visible to the graph and are not counted
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t CollabGraph::memory_footprint() const {
+    // A map node holds the key/value pair, a next pointer and cached hash
+    const size_t map_node = sizeof(void*) + sizeof(size_t);
+
+    size_t bytes = sizeof(*this);
+
+    if (unfrozen != nullptr) {
+        const auto& graph      = unfrozen->graph;
+        const auto& edge_index = unfrozen->edge_index;
+
+        bytes += sizeof(UnfrozenGraph);
+        bytes += graph.bucket_count() * sizeof(void*);
+        for (auto itr = graph.begin(); itr != graph.end(); itr++) {
+            bytes += map_node + sizeof(*itr) + itr->first.size();
+            bytes += sizeof(Vertex);
+            bytes += itr->second->neighbors.capacity() * sizeof(Edge);
+            for (const Edge& edge : itr->second->neighbors) {
+                // Both directions of an edge share its song
+                if (edge.neighbor->id > itr->second->id) {
+                    bytes += edge.song.size();
+                }
+            }
+        }
+        bytes += edge_index.bucket_count() * sizeof(void*);
+        bytes += edge_index.size() *
+                 (map_node + sizeof(pair<uint64_t, uint32_t>));
+    }
+
+    // The frozen image, whether it is owned or mapped from a snapshot, and
+    // whatever has been added to it since
+    bytes += image_size;
+    for (const string& name : added_names) {
+        bytes += sizeof(name) + name.capacity() + map_node +
+                 sizeof(pair<string_view, VertexId>);
+    }
+    for (const string& song : added_songs) {
+        bytes += sizeof(song) + song.capacity() + map_node +
+                 sizeof(pair<string_view, uint32_t>);
+    }
+    bytes += added_ids.bucket_count() * sizeof(void*);
+    bytes += added_song_ids.bucket_count() * sizeof(void*);
+    bytes += changed.capacity() * sizeof(uint32_t);
+    bytes += changed_lists.capacity() * sizeof(ChangedList);
+    for (const ChangedList& list : changed_lists) {
+        bytes += list.neighbors.capacity() * sizeof(VertexId);
+        bytes += list.songs.capacity() * sizeof(string_view);
+    }
+    bytes += added_postings.bucket_count() * sizeof(void*);
+    for (const auto& posting : added_postings) {
+        bytes += map_node + sizeof(posting);
+        bytes += posting.second.capacity() * sizeof(AddedPosting);
     }
+    bytes += metadata.memory_footprint() - sizeof(metadata);
 
-    graph.clear();
+    return bytes;
 }
 
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: enforce_valid_vertex
- * @purpose: ensure that the given artist is in the graph; throw an error if
- *           it is not. if an exception is not thrown, then the provided
- *           Artist instance maps to a vertex in the collaboration graph
+ * @function: freeze
+ * @purpose: convert the graph into its immutable, compressed sparse row
+ *           layout, where vertices are dense integer ids, every adjacency
+ *           list lives in one array, and songs are interned into one table
  *
- * @parameters: a const Artist reference, which should map to a vertex in
- *              the collaboration graph
+ * @preconditions: none
+ * @postconditions: 1) the graph is frozen, and every vertex's id is its
+ *                     insertion order
+ *                  2) each vertex's neighbors keep their order
+ *                  3) all traversal metadata is cleared
+ *                  4) the per-vertex heap structures are freed
+ * @parameters: none
  * @returns: none
+ *
+ * @notes: does nothing if the graph is already frozen. insert_vertex and
+ *         insert_edge throw a runtime_error on a frozen graph. The frozen
+ *         graph is a single image in the snapshot format (see
+ *         SnapshotHeader), so save_snapshot only has to write it out
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void CollabGraph::enforce_valid_vertex(const Artist& artist) const {
-    if (not is_vertex(artist)) {
-        string message = "artist \"" + artist.get_name() +
-                         "\" does not exist in the collaboration graph";
-        throw runtime_error(message.c_str());
+void CollabGraph::freeze() {
+    if (frozen) return;
+    STATS_TIMER(BUILD);
+
+    vector<Vertex*> by_id(vertex_count());
+    size_t          num_slots = 0;
+
+    if (unfrozen != nullptr) {
+        const auto& graph = unfrozen->graph;
+        for (auto itr = graph.begin(); itr != graph.end(); itr++) {
+            by_id[itr->second->id] = itr->second;
+            num_slots += itr->second->neighbors.size();
+        }
+    }
+
+    vector<uint64_t> new_offsets(1, 0), new_name_offsets(1, 0);
+    vector<uint64_t> new_song_offsets(1, 0);
+    vector<VertexId> new_adjacency;
+    vector<uint32_t> new_adjacency_songs;
+    string           new_name_chars, new_song_chars;
+
+    new_offsets.reserve(by_id.size() + 1);
+    new_name_offsets.reserve(by_id.size() + 1);
+    new_adjacency.reserve(num_slots);
+    new_adjacency_songs.reserve(num_slots);
+
+    unordered_map<string_view, uint32_t> song_ids;
+    bool                                 ascending = true;
+
+    for (VertexId v = 0; v < by_id.size(); v++) {
+        new_name_chars += by_id[v]->artist.get_name();
+        new_name_offsets.push_back(new_name_chars.size());
+
+        for (const Edge& edge : by_id[v]->neighbors) {
+            if (new_adjacency.size() > new_offsets.back() and
+                new_adjacency.back() > edge.neighbor->id) {
+                ascending = false;
+            }
+
+            uint32_t next_song = song_ids.size();
+            auto     song      = song_ids.insert({edge.song, next_song});
+            if (song.second) {
+                new_song_chars += edge.song;
+                new_song_offsets.push_back(new_song_chars.size());
+            }
+
+            new_adjacency.push_back(edge.neighbor->id);
+            new_adjacency_songs.push_back(song.first->second);
+        }
+
+        new_offsets.push_back(new_adjacency.size());
+    }
+
+    free_vertices();
+
+    SnapshotHeader header = SnapshotHeader();
+    header.num_vertices   = by_id.size();
+    header.num_slots      = new_adjacency.size();
+    header.num_songs      = song_ids.size();
+    header.name_bytes     = new_name_chars.size();
+    header.song_bytes     = new_song_chars.size();
+
+    // Lists that keep an order other than ascending need edge_order
+    header.order_slots = ascending ? 0 : new_adjacency.size();
+
+    uint64_t at[NUM_SECTIONS];
+    char*    base = allocate_image(header, at);
+
+    // Copy each section into place; seal_image builds the indexes and
+    // edge_order. The Artists' songs cannot be listed, so the catalog is
+    // left empty
+    const void* sections[NUM_SECTIONS] = {
+        new_offsets.data(),         new_adjacency.data(),
+        new_adjacency_songs.data(), new_name_offsets.data(),
+        new_song_offsets.data(),    nullptr,
+        new_name_chars.data(),      new_song_chars.data(),
+        nullptr,                    nullptr,
+        nullptr,                    nullptr,
+        nullptr,                    nullptr,
+        nullptr,                    nullptr,
+        nullptr};
+    size_t section_sizes[NUM_SECTIONS] = {
+        new_offsets.size() * sizeof(uint64_t),
+        new_adjacency.size() * sizeof(VertexId),
+        new_adjacency_songs.size() * sizeof(uint32_t),
+        new_name_offsets.size() * sizeof(uint64_t),
+        new_song_offsets.size() * sizeof(uint64_t),
+        0,
+        new_name_chars.size(),
+        new_song_chars.size(),
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0};
+
+    for (int i = 0; i < NUM_SECTIONS; i++) {
+        if (section_sizes[i] > 0) {
+            memcpy(base + at[i], sections[i], section_sizes[i]);
+        }
     }
+
+    seal_image(header, at);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: is_frozen
+ * @purpose: determine whether the graph uses its frozen layout
+ *
+ * @parameters: none
+ * @returns: a bool, true iff freeze() has been called on this graph
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::is_frozen() const {
+    return frozen;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: vertex_count
+ * @purpose: retrieve the number of vertices in the graph
+ *
+ * @parameters: none
+ * @returns: a size_t, the number of vertices; in a frozen graph, every
+ *           VertexId is less than this number
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t CollabGraph::vertex_count() const {
+    if (frozen) return num_vertices + added_names.size();
+
+    return unfrozen == nullptr ? 0 : unfrozen->graph.size();
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_vertex_id
+ * @purpose: translate an artist's name into its id in the frozen graph
+ *
+ * @parameters: a string_view, the name of an artist
+ * @returns: the VertexId of the artist, or NO_VERTEX if the artist is not
+ *           in the graph or the graph is not frozen
+ *
+ * @notes: this is the graph's name dictionary. Callers translate names
+ *         once, when a command arrives, and everything after that works
+ *         on ids, so each name is hashed exactly once per query
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::VertexId CollabGraph::get_vertex_id(string_view name) const {
+    if (not frozen) return NO_VERTEX;
+    STATS_COUNT(HASH_LOOKUPS, 1);
+
+    uint64_t bucket = fnv1a(name.data(), name.size()) & index_mask;
+
+    // Probe until the name is found or an empty bucket proves it is absent
+    while (name_index[bucket] != NO_VERTEX) {
+        VertexId vertex = name_index[bucket];
+        if (get_vertex_name(vertex) == name) return vertex;
+        bucket = (bucket + 1) & index_mask;
+    }
+
+    if (not added_ids.empty()) {
+        auto itr = added_ids.find(name);
+        if (itr != added_ids.end()) return itr->second;
+    }
+
+    return NO_VERTEX;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_vertex_name
+ * @purpose: translate a vertex id of the frozen graph into an artist name
+ *
+ * @parameters: a VertexId, which should be in the frozen graph
+ * @returns: a string_view of the name of the artist with that id, valid as
+ *           long as the graph stays frozen
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string_view CollabGraph::get_vertex_name(VertexId vertex) const {
+    enforce_valid_id(vertex);
+    if (vertex >= num_vertices) return added_names[vertex - num_vertices];
+    return string_view(name_chars + name_offsets[vertex],
+                       name_offsets[vertex + 1] - name_offsets[vertex]);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: neighbors_begin / neighbors_end
+ * @purpose: expose a vertex's neighbors in the frozen graph as a contiguous
+ *           range of ids, without copying them
+ *
+ * @parameters: a VertexId, which should be in the frozen graph
+ * @returns: a pointer to the first / one past the last neighbor id, in the
+ *           same order get_vertex_neighbors reports them
+ * @notes: the pointers are invalidated when an edge is added to the vertex
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+const CollabGraph::VertexId* CollabGraph::neighbors_begin(
+    VertexId vertex) const {
+    enforce_valid_id(vertex);
+    if (vertex < changed.size() and changed[vertex] != NO_CHANGE) {
+        return changed_lists[changed[vertex]].neighbors.data();
+    }
+    return adjacency + offsets[vertex];
+}
+
+const CollabGraph::VertexId* CollabGraph::neighbors_end(
+    VertexId vertex) const {
+    enforce_valid_id(vertex);
+    if (vertex < changed.size() and changed[vertex] != NO_CHANGE) {
+        const vector<VertexId>& neighbors = changed_lists[changed[vertex]]
+                                                .neighbors;
+        return neighbors.data() + neighbors.size();
+    }
+    return adjacency + offsets[vertex + 1];
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: adjacency_size
+ * @purpose: count the neighbors of every vertex of the frozen graph
+ *
+ * @parameters: none
+ * @returns: a uint64_t, the total length of all adjacency lists, which is
+ *           twice the number of edges
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t CollabGraph::adjacency_size() const {
+    return frozen ? offsets[num_vertices] + added_slots : 0;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_edge
+ * @purpose: retrieve the edge between two vertices of the frozen graph
+ *
+ * @parameters: two VertexIds, which should be in the frozen graph
+ * @returns: a string, the name of the edge connecting them, or the empty
+ *           string if there is no edge connecting them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string CollabGraph::get_edge(VertexId v1, VertexId v2) const {
+    enforce_valid_id(v1);
+    enforce_valid_id(v2);
+
+    string_view song;
+
+    return find_edge_song(v1, v2, song) ? string(song) : "";
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_edge
+ * @purpose: copy the edge between two vertices of the frozen graph into a
+ *           caller-owned string, so a reused string never reallocates once
+ *           it is big enough
+ *
+ * @parameters: 1) two VertexIds, which should be in the frozen graph
+ *              2) a string reference, set to the name of the edge, or to
+ *                 the empty string if there is no edge
+ * @returns: a bool, true iff there is an edge connecting the vertices
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::get_edge(VertexId v1, VertexId v2, string& song) const {
+    enforce_valid_id(v1);
+    enforce_valid_id(v2);
+
+    string_view found;
+    if (not find_edge_song(v1, v2, found)) {
+        song.clear();
+        return false;
+    }
+
+    song.assign(found);
+    return true;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_edge_view
+ * @purpose: find the edge between two vertices of the frozen graph without
+ *           copying its name, for callers that only print it
+ *
+ * @parameters: 1) two VertexIds, which should be in the frozen graph
+ *              2) a string_view reference, set to the name of the edge, or
+ *                 to an empty view if there is no edge
+ * @returns: a bool, true iff there is an edge connecting the vertices
+ *
+ * @notes: the view points into the graph, and is only valid until the graph
+ *         is next changed
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::get_edge_view(VertexId v1, VertexId v2,
+                                string_view& song) const {
+    enforce_valid_id(v1);
+    enforce_valid_id(v2);
+
+    if (not find_edge_song(v1, v2, song)) {
+        song = string_view();
+        return false;
+    }
+    return true;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: mark_vertex / is_marked
+ * @purpose: set or query the visited flag of a vertex of the frozen graph
+ *
+ * @parameters: a VertexId, which should be in the frozen graph
+ * @returns: none / a bool, true iff the vertex has been visited
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::mark_vertex(VertexId vertex) {
+    enforce_valid_id(vertex);
+    frozen_metadata().mark_vertex(vertex);
+}
+
+bool CollabGraph::is_marked(VertexId vertex) const {
+    enforce_valid_id(vertex);
+    return frozen_metadata().is_marked(vertex);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: set_predecessor
+ * @purpose: update the predecessor of the 'to' vertex of the frozen graph
+ *
+ * @parameters: two VertexIds, the vertex whose predecessor is set and the
+ *              predecessor itself
+ * @returns: none
+ * @note: does nothing if 'to' already has a predecessor
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::set_predecessor(VertexId to, VertexId from) {
+    enforce_valid_id(to);
+    enforce_valid_id(from);
+
+    frozen_metadata().set_predecessor(to, from);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_predecessor
+ * @purpose: retrieve the predecessor of a vertex of the frozen graph
+ *
+ * @parameters: a VertexId, which should be in the frozen graph
+ * @returns: the VertexId of its predecessor, or NO_VERTEX if it has none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::VertexId CollabGraph::get_predecessor(VertexId vertex) const {
+    enforce_valid_id(vertex);
+    return frozen_metadata().get_predecessor(vertex);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: build_landmarks
+ * @purpose: pick landmark vertices among those with the most neighbors and
+ *           record how far every vertex is from each of them, so that
+ *           distance_bounds can bound the distance between any two
+ *           vertices without searching
+ *
+ * @preconditions: the graph is frozen
+ * @parameters: 1) a size_t, how many landmarks to use; each costs one byte
+ *                 per vertex and tightens the bounds, and 0 removes them
+ *              2) an unsigned, how many threads to search with, one
+ *                 landmark at a time each
+ * @returns: none
+ *
+ * @postconditions: the landmarks are part of the frozen image, so
+ *                  save_snapshot saves them; a mapped snapshot is copied
+ *                  onto the heap
+ * @notes: throws a runtime_error if the graph is not frozen or has had
+ *         artists or songs added. Fewer than count landmarks are used if
+ *         the graph runs out of candidates (see choose_landmarks)
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::build_landmarks(size_t count, unsigned num_threads) {
+    STATS_TIMER(BUILD);
+
+    if (not frozen) {
+        throw runtime_error("landmarks can only be built on a frozen graph");
+    }
+    if (has_updates()) {
+        throw runtime_error("landmarks cannot be built once artists or songs "
+                            "have been added");
+    }
+
+    vector<VertexId> chosen;
+    choose_landmarks(count, chosen);
+
+    SnapshotHeader header;
+    memcpy(&header, image_base, sizeof(header));
+    header.num_landmarks = chosen.size();
+
+    uint64_t at[NUM_SECTIONS];
+    header.total_size = layout_sections(header, at);
+
+    // The landmark sections come last, so every other section keeps its
+    // place and is copied as it is
+    size_t           num_words = header.total_size / sizeof(uint64_t);
+    uint64_t*        words     = new uint64_t[num_words]();
+    shared_ptr<void> new_image(words, default_delete<uint64_t[]>());
+    char*            base = reinterpret_cast<char*>(words);
+    memcpy(base + sizeof(header), image_base + sizeof(header),
+           at[15] - sizeof(header));
+    memcpy(base + at[15], chosen.data(), chosen.size() * sizeof(VertexId));
+
+    // Landmark i's breadth first search fills in byte i of every vertex
+    uint8_t* distances = reinterpret_cast<uint8_t*>(base + at[16]);
+    size_t   stride    = chosen.size();
+    memset(distances, LANDMARK_UNREACHED, num_vertices * stride);
+
+    run_tasks(max(num_threads, 1u), stride, [&](unsigned, size_t i) {
+        vector<VertexId> queue(1, chosen[i]);
+        distances[chosen[i] * stride + i] = 0;
+
+        for (size_t head = 0; head < queue.size(); head++) {
+            VertexId v    = queue[head];
+            uint8_t  next = distances[v * stride + i] == LANDMARK_FAR
+                                ? LANDMARK_FAR
+                                : distances[v * stride + i] + 1;
+
+            for (uint64_t slot = offsets[v]; slot < offsets[v + 1]; slot++) {
+                uint8_t& distance = distances[adjacency[slot] * stride + i];
+                if (distance == LANDMARK_UNREACHED) {
+                    distance = next;
+                    queue.push_back(adjacency[slot]);
+                }
+            }
+        }
+    });
+
+    memcpy(base, &header, sizeof(header));
+
+    // Replace the old image, which copies of this graph may still be using
+    image = move(new_image);
+
+    attach(base, header.total_size, false);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: landmark_count / get_landmark
+ * @purpose: retrieve the landmarks built by build_landmarks
+ *
+ * @parameters: none / a size_t, the index of a landmark
+ * @returns: the number of landmarks / the VertexId of a landmark
+ * @notes: get_landmark throws a runtime_error if there is no such landmark
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t CollabGraph::landmark_count() const {
+    return num_landmarks;
+}
+
+CollabGraph::VertexId CollabGraph::get_landmark(size_t index) const {
+    if (index >= num_landmarks) {
+        throw runtime_error("landmark " + to_string(index) +
+                            " does not exist in the collaboration graph");
+    }
+    return landmarks[index];
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: distance_bounds
+ * @purpose: bound the number of hops between two vertices of the frozen
+ *           graph using only their distances from the landmarks, in time
+ *           proportional to the number of landmarks
+ *
+ * @parameters: 1) two VertexIds, which should be in the frozen graph
+ *              2) two uint32_t references, set to a lower bound and an
+ *                 upper bound on the distance (NO_BOUND if no landmark
+ *                 reaches both vertices)
+ * @returns: a bool, false iff some landmark reaches exactly one of the
+ *           vertices, which proves no path connects them; both bounds are
+ *           then NO_BOUND
+ *
+ * @notes: by the triangle inequality, a landmark d1 hops from v1 and d2
+ *         hops from v2 puts them at least |d1 - d2| and at most d1 + d2
+ *         hops apart. The bounds are exact when v1 or v2 is a landmark.
+ *         With no landmarks, the bounds only tell equal vertices apart
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::distance_bounds(VertexId v1, VertexId v2, uint32_t& lower,
+                                  uint32_t& upper) const {
+    enforce_valid_id(v1);
+    enforce_valid_id(v2);
+
+    lower = v1 == v2 ? 0 : 1;
+    upper = v1 == v2 ? 0 : NO_BOUND;
+
+    const uint8_t* from1 = landmark_distances + v1 * num_landmarks;
+    const uint8_t* from2 = landmark_distances + v2 * num_landmarks;
+
+    for (size_t i = 0; i < num_landmarks; i++) {
+        uint32_t d1 = from1[i], d2 = from2[i];
+
+        if (d1 == LANDMARK_UNREACHED or d2 == LANDMARK_UNREACHED) {
+            if (d1 != d2) {
+                lower = upper = NO_BOUND;
+                return false;
+            }
+        } else if (d1 != LANDMARK_FAR and d2 != LANDMARK_FAR) {
+            lower = max(lower, d1 > d2 ? d1 - d2 : d2 - d1);
+            upper = min(upper, d1 + d2);
+        }
+    }
+
+    return true;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: add_artist
+ * @purpose: add an artist and its songs to the frozen graph, connecting it
+ *           to every artist that already has one of its songs
+ *
+ * @preconditions: the graph is frozen
+ * @parameters: 1) a string_view, the new artist's name
+ *              2) the artist's songs, in the order of its discography
+ * @returns: none
+ *
+ * @postconditions: the artist's id is the old vertex_count(), and it is
+ *                  connected as if add_song were called with each of its
+ *                  songs in order
+ * @notes: throws a runtime_error if the graph is not frozen, or the name is
+ *         empty or already in the graph
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::add_artist(string_view                name,
+                             const vector<string_view>& songs) {
+    STATS_TIMER(UPDATE);
+
+    if (not frozen) {
+        throw runtime_error("artists can only be added to a frozen graph");
+    }
+    if (name.empty()) {
+        string message = "cannot insert an improperly initialized "
+                         "Artist instance (name must be non-empty)";
+        throw runtime_error(message.c_str());
+    }
+    if (get_vertex_id(name) != NO_VERTEX) {
+        string message = "artist \"" + string(name) +
+                         "\" already exists in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+
+    VertexId artist = vertex_count();
+    added_names.push_back(string(name));
+    added_ids.insert({added_names.back(), artist});
+    changed_list(artist);
+    num_landmarks = 0;
+
+    for (string_view song : songs) add_posting(artist, song);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: add_song
+ * @purpose: add a song to the discography of an artist in the frozen graph,
+ *           connecting the artist to every other artist with that song that
+ *           it is not already connected to
+ *
+ * @preconditions: the graph is frozen
+ * @parameters: 1) a string_view, the name of an artist in the graph
+ *              2) a string_view, the song
+ * @returns: none
+ *
+ * @notes: 1) the graph ends up with the edges, and edge names, it would have
+ *            if it were built from the data with the song appended to the
+ *            artist's list (and, for add_artist, the artist appended to the
+ *            data), as long as no empty songs are involved: like a built
+ *            graph, the empty song connects no one, but it does not stop
+ *            a later shared song from connecting two artists
+ *         2) only the song's own artists are visited, found through the
+ *            catalog, so this takes time proportional to how many there are
+ *            and how many neighbors they have, not to the size of the graph
+ *         3) a song the artist already has changes nothing
+ *         4) throws a runtime_error if the graph is not frozen or the
+ *            artist is not in it
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::add_song(string_view artist, string_view song) {
+    STATS_TIMER(UPDATE);
+
+    if (not frozen) {
+        throw runtime_error("songs can only be added to a frozen graph");
+    }
+
+    VertexId vertex = get_vertex_id(artist);
+    if (vertex == NO_VERTEX) {
+        string message = "artist \"" + string(artist) +
+                         "\" does not exist in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+
+    add_posting(vertex, song);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: has_updates
+ * @purpose: determine whether artists or songs have been added to the
+ *           frozen graph since it was built or loaded
+ *
+ * @parameters: none
+ * @returns: a bool, true iff add_artist or add_song changed the graph
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::has_updates() const {
+    return not added_names.empty() or not added_postings.empty();
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: save_snapshot
+ * @purpose: write the frozen graph to a binary snapshot file, which
+ *           load_snapshot can later map and use without rebuilding it
+ *
+ * @preconditions: the graph is frozen
+ * @parameters: a const string reference, the path of the file to write
+ * @returns: none
+ *
+ * @notes: throws a runtime_error if the graph is not frozen, has had artists
+ *         or songs added (which live outside the image), or the file cannot
+ *         be written
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::save_snapshot(const string& path) const {
+    if (not frozen) {
+        throw runtime_error("only a frozen graph can be saved as a snapshot");
+    }
+    if (has_updates()) {
+        throw runtime_error("a graph cannot be saved as a snapshot once "
+                            "artists or songs have been added");
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, image_base, sizeof(header));
+    header.checksum = fnv1a(image_base + sizeof(header),
+                            image_size - sizeof(header));
+
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(image_base + sizeof(header), image_size - sizeof(header));
+    out.close();
+
+    if (out.fail()) {
+        throw runtime_error("cannot write snapshot " + path);
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: load_snapshot
+ * @purpose: replace this graph with the frozen graph in a snapshot file,
+ *           by mapping the file into memory and using it in place
+ *
+ * @parameters: 1) a const string reference, the path of the snapshot
+ *              2) a bool, true to also verify the snapshot's checksum,
+ *                 which reads the rest of the file
+ * @returns: none
+ *
+ * @postconditions: the graph is frozen and identical to the one that was
+ *                  saved; nothing is copied onto the heap
+ * @notes: throws a runtime_error if the file cannot be mapped or is not a
+ *         valid snapshot, in which case the graph is left empty. Every id
+ *         and offset in the file is checked (check_sections), so a corrupt
+ *         file is rejected rather than read out of bounds; without the
+ *         checksum, names and songs are not read until queries use them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::load_snapshot(const string& path, bool verify) {
+    STATS_TIMER(BUILD);
+
+    self_destruct();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("cannot open snapshot " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 or info.st_size == 0) {
+        close(fd);
+        throw runtime_error("cannot read snapshot " + path);
+    }
+
+    void* region = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        throw runtime_error("cannot map snapshot " + path);
+    }
+
+    size_t size = info.st_size;
+    image.reset(region, [size](void* mapped) { munmap(mapped, size); });
+
+    try {
+        attach(static_cast<const char*>(region), info.st_size, verify);
+        check_sections(static_cast<const char*>(region));
+    } catch (const runtime_error& e) {
+        self_destruct();
+        throw runtime_error(path + ": " + e.what());
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: is_snapshot
+ * @purpose: determine whether a file starts like a graph snapshot, rather
+ *           than a text data file
+ *
+ * @parameters: a const string reference, the path of the file
+ * @returns: a bool, true iff the file starts with the snapshot magic
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::is_snapshot(const string& path) {
+    char     magic[sizeof(SNAPSHOT_MAGIC)];
+    ifstream in(path, ios::binary);
+
+    in.read(magic, sizeof(magic));
+    return in.good() and memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+
+/*********************************************************************
+ ******************** Builder function definitions *******************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: Builder constructor
+ * @purpose: start building a frozen graph into the given CollabGraph
+ *
+ * @parameters: a CollabGraph reference, which finish() replaces with the
+ *              built graph
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::Builder::Builder(CollabGraph& graph) : target(graph) {
+    name_offsets.push_back(0);
+    collab_offsets.push_back(0);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: Builder::add_artist
+ * @purpose: add the next artist, and its edges to every artist added
+ *           before it
+ *
+ * @parameters: 1) a string_view, the artist's name
+ *              2) the artist's songs, in the order populate_graph would
+ *                 see them in its discography
+ * @returns: none
+ *
+ * @notes: 1) like populate_graph, the edge between artists i < j is named
+ *            by the first song in i's list that j also has, and there is
+ *            no edge if that song is the empty string. Each song keeps a
+ *            posting list of the artists that have it and where, so only
+ *            earlier artists that share a song with this one are visited
+ *         2) throws a runtime_error if the name is empty or was already
+ *            added, since populate_graph cannot build either
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::Builder::add_artist(string_view                name,
+                                      const vector<string_view>& songs) {
+    STATS_TIMER(BUILD);
+    STATS_COUNT(HASH_LOOKUPS, 1 + songs.size());
+
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    if (name.empty()) {
+        string message = "cannot insert an improperly initialized "
+                         "Artist instance (name must be non-empty)";
+        throw runtime_error(message.c_str());
+    }
+
+    VertexId artist = collab_offsets.size() - 1;
+    if (not ids.insert({name, artist}).second) {
+        string message = "artist \"" + string(name) +
+                         "\" appears more than once in the data";
+        throw runtime_error(message.c_str());
+    }
+
+    name_chars.append(name.data(), name.size());
+    name_offsets.push_back(name_chars.size());
+    claimed_by.push_back(NO_VERTEX);
+    claims.push_back(Claim());
+    partners.clear();
+
+    for (uint32_t position = 0; position < songs.size(); position++) {
+        uint32_t next_song = song_names.size();
+        auto     song      = song_ids.insert({songs[position], next_song});
+        if (song.second) {
+            song_names.push_back(songs[position]);
+            postings.push_back(vector<Posting>());
+            seen_by.push_back(NO_VERTEX);
+        }
+        stats.song_occurrences++;
+
+        // Only the first time this artist lists a song can name an edge
+        uint32_t id = song.first->second;
+        if (seen_by[id] == artist) continue;
+        seen_by[id] = artist;
+
+        for (const Posting& posting : postings[id]) {
+            VertexId partner = posting.artist;
+            stats.postings_scanned++;
+
+            if (claimed_by[partner] != artist) {
+                claimed_by[partner] = artist;
+                claims[partner]     = {posting.position, id};
+                partners.push_back(partner);
+            } else if (posting.position < claims[partner].position) {
+                claims[partner] = {posting.position, id};
+            }
+        }
+
+        postings[id].push_back({artist, position});
+    }
+
+    sort(partners.begin(), partners.end());
+
+    for (VertexId partner : partners) {
+        // An empty first shared song means "no collaboration" as before
+        if (not song_names[claims[partner].song].empty()) {
+            collabs.push_back({partner, claims[partner].song});
+        }
+    }
+    collab_offsets.push_back(collabs.size());
+
+    stats.index_ms += chrono::duration<double, milli>(Clock::now() - start)
+                          .count();
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: Builder::finish
+ * @purpose: lay the artists and edges added so far out as a frozen graph
+ *
+ * @parameters: none
+ * @returns: none
+ *
+ * @postconditions: 1) the target graph is frozen, holding exactly the
+ *                     added artists, with ids in the order they were added
+ *                  2) its build stats describe this build, where index
+ *                     time is the time spent in add_artist
+ *                  3) the builder is empty
+ * @notes: the song index is freed before the image is allocated, except
+ *         for the postings, which go in the image's catalog and are freed
+ *         once they are copied there. The adjacency lists are written
+ *         straight into the image, so the image and the edge list are the
+ *         most that is held at once
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::Builder::finish() {
+    STATS_TIMER(BUILD);
+
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    VertexId num_artists = collab_offsets.size() - 1;
+
+    stats.artists        = num_artists;
+    stats.distinct_songs = song_names.size();
+    stats.edges          = collabs.size();
+
+    uint64_t catalog_bytes = 0, num_postings = 0;
+    for (uint32_t song = 0; song < song_names.size(); song++) {
+        catalog_bytes += song_names[song].size();
+        num_postings += postings[song].size();
+    }
+
+    unordered_map<string_view, VertexId>().swap(ids);
+    unordered_map<string_view, uint32_t>().swap(song_ids);
+    vector<VertexId>().swap(seen_by);
+    vector<VertexId>().swap(claimed_by);
+    vector<Claim>().swap(claims);
+    vector<VertexId>().swap(partners);
+
+    // Only the songs that name an edge go in the song table
+    vector<bool> used(song_names.size(), false);
+    uint64_t     num_songs = 0, song_bytes = 0;
+
+    for (const Collab& collab : collabs) {
+        if (not used[collab.song]) {
+            used[collab.song] = true;
+            num_songs++;
+            song_bytes += song_names[collab.song].size();
+        }
+    }
+    vector<bool>().swap(used);
+
+    target.self_destruct();
+
+    SnapshotHeader header = SnapshotHeader();
+    header.num_vertices   = num_artists;
+    header.num_slots      = 2 * collabs.size();
+    header.num_songs      = num_songs;
+    header.name_bytes     = name_chars.size();
+    header.song_bytes     = song_bytes;
+    header.catalog_songs  = song_names.size();
+    header.catalog_bytes  = catalog_bytes;
+    header.num_postings   = num_postings;
+
+    uint64_t at[NUM_SECTIONS];
+    char*    base = target.allocate_image(header, at);
+
+    // Songs are numbered in the order the data first lists them, which is
+    // the catalog's order
+    vector<uint32_t> order(song_names.size());
+    for (uint32_t song = 0; song < song_names.size(); song++) {
+        order[song] = song;
+    }
+    write_catalog_names(base, at, song_names, order);
+
+    uint64_t* posting_offsets   = reinterpret_cast<uint64_t*>(base + at[12]);
+    VertexId* posting_artists   = reinterpret_cast<VertexId*>(base + at[13]);
+    uint32_t* posting_positions = reinterpret_cast<uint32_t*>(base + at[14]);
+    for (uint32_t song = 0; song < song_names.size(); song++) {
+        uint64_t next = posting_offsets[song];
+        for (const Posting& posting : postings[song]) {
+            posting_artists[next]   = posting.artist;
+            posting_positions[next] = posting.position;
+            next++;
+        }
+        posting_offsets[song + 1] = next;
+    }
+    vector<vector<Posting>>().swap(postings);
+    vector<uint32_t>().swap(order);
+
+    uint64_t* offsets         = reinterpret_cast<uint64_t*>(base + at[0]);
+    VertexId* adjacency       = reinterpret_cast<VertexId*>(base + at[1]);
+    uint32_t* adjacency_songs = reinterpret_cast<uint32_t*>(base + at[2]);
+
+    for (VertexId v = 0; v < num_artists; v++) {
+        for (uint64_t c = collab_offsets[v]; c < collab_offsets[v + 1]; c++) {
+            offsets[v + 1]++;
+            offsets[collabs[c].partner + 1]++;
+        }
+    }
+    for (VertexId v = 0; v < num_artists; v++) offsets[v + 1] += offsets[v];
+
+    /* Artist v's edges to earlier artists are filled in (ascending) when v
+     * is reached, and its edges to later artists as each of those is
+     * reached, so every list ends up in ascending order, which is the
+     * order populate_graph inserts them in
+     */
+    vector<uint64_t> next_slot(offsets, offsets + num_artists);
+    for (VertexId v = 0; v < num_artists; v++) {
+        for (uint64_t c = collab_offsets[v]; c < collab_offsets[v + 1]; c++) {
+            VertexId partner = collabs[c].partner;
+            uint64_t mine    = next_slot[v]++;
+            uint64_t theirs  = next_slot[partner]++;
+
+            adjacency[mine]         = partner;
+            adjacency_songs[mine]   = collabs[c].song;
+            adjacency[theirs]       = v;
+            adjacency_songs[theirs] = collabs[c].song;
+        }
+    }
+    vector<uint64_t>().swap(next_slot);
+    vector<Collab>().swap(collabs);
+    vector<uint64_t>().swap(collab_offsets);
+
+    memcpy(base + at[3], name_offsets.data(),
+           name_offsets.size() * sizeof(uint64_t));
+    if (not name_chars.empty()) {
+        memcpy(base + at[6], name_chars.data(), name_chars.size());
+    }
+
+    write_song_table(base, at, header.num_slots, song_names);
+    target.seal_image(header, at);
+
+    stats.edges_ms =
+        chrono::duration<double, milli>(Clock::now() - start).count();
+    target.build_stats = stats;
+
+    // Leave the builder empty, ready for another graph
+    string().swap(name_chars);
+    vector<uint64_t>(1, 0).swap(name_offsets);
+    vector<uint64_t>(1, 0).swap(collab_offsets);
+    vector<string_view>().swap(song_names);
+    stats = BuildStats();
+}
+
+
+/*********************************************************************
+ ****************** SearchState function definitions *****************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: SearchState::clear
+ * @purpose: prepare the state for a new traversal of a frozen graph
+ *
+ * @parameters: a size_t, the number of vertices in the graph to traverse
+ * @returns: none
+ *
+ * @notes: O(1) unless the number of vertices changed or the epoch counter
+ *         wrapped around, in which case every stamp is reset
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::SearchState::clear(size_t num_vertices) {
+    STATS_TIMER(CLEAR);
+
+    epoch++;
+    excluded = nullptr;
+
+    if (epoch == 0 or metadata.size() != num_vertices) {
+        metadata.assign(num_vertices, Metadata());
+        epoch = 1;
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: SearchState::mark_vertex / unmark_vertex / is_marked
+ * @purpose: set, reset, or query the visited flag of a vertex
+ *
+ * @preconditions: the vertex is less than the number given to clear()
+ * @parameters: a VertexId
+ * @returns: none / none / a bool, true iff the vertex has been visited
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::SearchState::mark_vertex(VertexId vertex) {
+    metadata[vertex].marked = epoch;
+}
+
+void CollabGraph::SearchState::unmark_vertex(VertexId vertex) {
+    metadata[vertex].marked = 0;
+}
+
+bool CollabGraph::SearchState::is_marked(VertexId vertex) const {
+    return metadata[vertex].marked == epoch or
+           (excluded != nullptr and
+            (excluded[vertex / 64] >> (vertex % 64) & 1) != 0);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: SearchState::exclude
+ * @purpose: mark every vertex of a set at once, as not marks the artists it
+ *           excludes, without a lookup or a write per vertex
+ *
+ * @preconditions: the bitmap has a bit for every vertex less than the
+ *                 number given to clear(), and outlives the search
+ * @postconditions: until the next clear(), a vertex whose bit is set is
+ *                  marked, and stays marked even if it is unmarked
+ * @parameters: a bitmap of vertices, bit v % 64 of word v / 64 for vertex v
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::SearchState::exclude(const uint64_t* bitmap) {
+    excluded = bitmap;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: SearchState::set_predecessor / get_predecessor
+ * @purpose: set or retrieve the predecessor of a vertex
+ *
+ * @preconditions: the vertices are less than the number given to clear()
+ * @parameters: the vertex whose predecessor is set or retrieved, and for
+ *              set_predecessor the predecessor itself
+ * @returns: none / the predecessor, or NO_VERTEX if there is none
+ * @note: set_predecessor does nothing if 'to' already has a predecessor
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::SearchState::set_predecessor(VertexId to, VertexId from) {
+    if (metadata[to].stamped != epoch) {
+        metadata[to].stamped     = epoch;
+        metadata[to].predecessor = from;
+    }
+}
+
+CollabGraph::VertexId CollabGraph::SearchState::get_predecessor(
+    VertexId vertex) const {
+    if (metadata[vertex].stamped != epoch) return NO_VERTEX;
+    return metadata[vertex].predecessor;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: SearchState::size
+ * @purpose: report how many vertices the state is sized for
+ *
+ * @parameters: none
+ * @returns: a size_t, the number given to the last clear()
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t CollabGraph::SearchState::size() const {
+    return metadata.size();
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: SearchState::memory_footprint
+ * @purpose: report the number of bytes used by the state
+ *
+ * @parameters: none
+ * @returns: a size_t, the size of the state in bytes
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t CollabGraph::SearchState::memory_footprint() const {
+    return sizeof(*this) + metadata.capacity() * sizeof(Metadata);
+}
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: self_destruct
+ * @purpose: free all memory associated with this CollabGraph instance
+ *
+ * @parameters: none
+ * @returns: none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::self_destruct() {
+    free_vertices();
+    detach();
+    metadata = SearchState();
+
+    deque<string>().swap(added_names);
+    unordered_map<string_view, VertexId>().swap(added_ids);
+    vector<uint32_t>().swap(changed);
+    vector<ChangedList>().swap(changed_lists);
+    deque<string>().swap(added_songs);
+    unordered_map<string_view, uint32_t>().swap(added_song_ids);
+    unordered_map<uint32_t, vector<AddedPosting>>().swap(added_postings);
+    added_slots   = 0;
+    next_position = UINT64_C(1) << 32;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: detach
+ * @purpose: let go of the frozen image and every view into it
+ *
+ * @parameters: none
+ * @returns: none
+ *
+ * @notes: never allocates, so the move operations can use it
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::detach() {
+    image.reset();
+
+    frozen             = false;
+    image_base         = nullptr;
+    image_size         = 0;
+    num_vertices       = 0;
+    index_mask         = 0;
+    offsets            = nullptr;
+    adjacency          = nullptr;
+    adjacency_songs    = nullptr;
+    name_offsets       = nullptr;
+    song_offsets       = nullptr;
+    name_index         = nullptr;
+    name_chars         = nullptr;
+    song_chars         = nullptr;
+    edge_order         = nullptr;
+    catalog_songs      = 0;
+    catalog_mask       = 0;
+    catalog_offsets    = nullptr;
+    catalog_chars      = nullptr;
+    catalog_index      = nullptr;
+    posting_offsets    = nullptr;
+    posting_artists    = nullptr;
+    posting_positions  = nullptr;
+    num_landmarks      = 0;
+    landmarks          = nullptr;
+    landmark_distances = nullptr;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: free_vertices
+ * @purpose: free the unfrozen graph's vertices, edges and songs
+ *
+ * @parameters: none
+ * @returns: none
+ *
+ * @notes: only the Artist in each vertex owns memory outside the arena, so
+ *         that is all that is destroyed one vertex at a time; the arena
+ *         then returns its blocks to the heap in one pass
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::free_vertices() {
+    if (unfrozen == nullptr) return;
+
+    const auto& graph = unfrozen->graph;
+    for (auto itr = graph.begin(); itr != graph.end(); itr++) {
+        itr->second->~Vertex();
+    }
+
+    // The maps let go of their arena memory before the arena is destroyed
+    unfrozen.reset();
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: copy_vertices
+ * @purpose: copy another graph's unfrozen graph into this one, which has
+ *           none
+ *
+ * @parameters: the unfrozen graph to copy
+ * @returns: none
+ *
+ * @notes: vertices are made in id order and each neighbor list is copied
+ *         in order, so the copy has the same ids, lists and edge_index.
+ *         As in insert_edge, both directions of an edge share one copy of
+ *         its song: the endpoint with the smaller id makes it, and the
+ *         other finds it through edge_index
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::copy_vertices(const UnfrozenGraph& source) {
+    size_t                num = source.graph.size();
+    vector<const Vertex*> from(num);
+    vector<string_view>   names(num);
+
+    for (auto itr = source.graph.begin(); itr != source.graph.end(); itr++) {
+        from[itr->second->id]  = itr->second;
+        names[itr->second->id] = itr->first;
+    }
+
+    unfrozen = make_unique<UnfrozenGraph>();
+    pmr::monotonic_buffer_resource& arena = unfrozen->arena;
+
+    // Assigning keeps this graph's arena, where copying would not
+    unfrozen->edge_index = source.edge_index;
+    unfrozen->graph.reserve(num);
+
+    vector<Vertex*> to(num);
+    for (VertexId v = 0; v < num; v++) {
+        void*   memory = arena.allocate(sizeof(Vertex), alignof(Vertex));
+        Vertex* vertex = new (memory) Vertex(from[v]->artist, &arena);
+        vertex->id      = v;
+        vertex->visited = from[v]->visited;
+        unfrozen->graph.insert({arena_copy(names[v]), vertex});
+        to[v] = vertex;
+    }
+
+    for (VertexId v = 0; v < num; v++) {
+        if (from[v]->predecessor != nullptr) {
+            to[v]->predecessor = to[from[v]->predecessor->id];
+        }
+
+        to[v]->neighbors.reserve(from[v]->neighbors.size());
+        for (const Edge& edge : from[v]->neighbors) {
+            Vertex*     neighbor = to[edge.neighbor->id];
+            string_view song;
+            if (neighbor->id > v) {
+                song = arena_copy(edge.song);
+            } else {
+                song = find_edge(to[v], neighbor)->song;
+            }
+            to[v]->neighbors.push_back(Edge(neighbor, song));
+        }
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: copy_updates
+ * @purpose: copy the artists and songs added to another frozen graph into
+ *           this one, which shares its image and has no updates of its own
+ *
+ * @parameters: the graph to copy from
+ * @returns: none
+ *
+ * @notes: the maps of added names and songs hold views of the strings in
+ *         added_names and added_songs, so they are rebuilt to view this
+ *         graph's copies, as are the songs of changed lists that were
+ *         added; the songs from the image are the same in both graphs
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::copy_updates(const CollabGraph& source) {
+    added_names = source.added_names;
+    added_ids.reserve(added_names.size());
+    for (size_t i = 0; i < added_names.size(); i++) {
+        added_ids.insert({added_names[i], num_vertices + i});
+    }
+
+    added_songs = source.added_songs;
+    added_song_ids.reserve(added_songs.size());
+    for (size_t i = 0; i < added_songs.size(); i++) {
+        added_song_ids.insert({added_songs[i], catalog_songs + i});
+    }
+
+    changed       = source.changed;
+    changed_lists = source.changed_lists;
+    for (ChangedList& list : changed_lists) {
+        for (string_view& song : list.songs) {
+            if (song.data() >= image_base and
+                song.data() <= image_base + image_size) {
+                continue;
+            }
+            auto added = added_song_ids.find(song);
+            if (added != added_song_ids.end()) song = added->first;
+        }
+    }
+
+    added_postings = source.added_postings;
+    added_slots    = source.added_slots;
+    next_position  = source.next_position;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: arena_copy
+ * @purpose: copy text into the graph's arena
+ *
+ * @parameters: the text to copy
+ * @returns: a string_view of the copy, valid until the vertices are freed
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string_view CollabGraph::arena_copy(string_view text) {
+    char* copy = static_cast<char*>(unfrozen->arena.allocate(text.size(), 1));
+    memcpy(copy, text.data(), text.size());
+    return string_view(copy, text.size());
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: find_vertex
+ * @purpose: ensure that the given artist is in the (unfrozen) graph, and
+ *           find its vertex with a single lookup; throw an error if it is
+ *           not in the graph
+ *
+ * @parameters: a const Artist reference, which should map to a vertex in
+ *              the collaboration graph
+ * @returns: a pointer to the artist's vertex
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::Vertex* CollabGraph::find_vertex(const Artist& artist) const {
+    Vertex* vertex = nullptr;
+    if (unfrozen != nullptr) {
+        auto itr = unfrozen->graph.find(artist.get_name());
+        if (itr != unfrozen->graph.end()) vertex = itr->second;
+    }
+
+    if (vertex == nullptr) {
+        string message = "artist \"" + artist.get_name() +
+                         "\" does not exist in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+
+    return vertex;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: edge_key
+ * @purpose: compute the key of the edge between two vertices in edge_index
+ *
+ * @parameters: two vertices of the unfrozen graph, in either order
+ * @returns: a uint64_t holding the smaller id in its high half and the
+ *           larger id in its low half
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t CollabGraph::edge_key(const Vertex* v1, const Vertex* v2) {
+    uint64_t lower  = min(v1->id, v2->id);
+    uint64_t higher = max(v1->id, v2->id);
+    return lower << 32 | higher;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: find_edge
+ * @purpose: find the edge between two vertices of the unfrozen graph with
+ *           one lookup in edge_index, however many neighbors they have
+ *
+ * @parameters: two vertices of the unfrozen graph
+ * @returns: a pointer to the edge in the neighbors of the vertex with the
+ *           smaller id, or nullptr if there is no edge connecting them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+const CollabGraph::Edge* CollabGraph::find_edge(const Vertex* v1,
+                                                const Vertex* v2) const {
+    auto itr = unfrozen->edge_index.find(edge_key(v1, v2));
+    if (itr == unfrozen->edge_index.end()) return nullptr;
+
+    const Vertex* lower = v1->id < v2->id ? v1 : v2;
+    return &lower->neighbors[itr->second];
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: enforce_mutable
+ * @purpose: ensure that the graph can still be modified; throw an error if
+ *           it has been frozen
+ *
+ * @parameters: none
+ * @returns: none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::enforce_mutable() const {
+    if (frozen) {
+        string message = "cannot modify a frozen collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: frozen_id
+ * @purpose: translate an artist into its id in the frozen graph, with the
+ *           same error as find_vertex if it is not in the graph
+ *
+ * @parameters: a const Artist reference, which should map to a vertex in
+ *              the collaboration graph
+ * @returns: the VertexId of the artist
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::VertexId CollabGraph::frozen_id(const Artist& artist) const {
+    VertexId vertex = get_vertex_id(artist.get_name());
+
+    if (vertex == NO_VERTEX) {
+        string message = "artist \"" + artist.get_name() +
+                         "\" does not exist in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+
+    return vertex;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: enforce_valid_id
+ * @purpose: ensure that the given id names a vertex of the frozen graph;
+ *           throw an error if it does not
+ *
+ * @parameters: a VertexId
+ * @returns: none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::enforce_valid_id(VertexId vertex) const {
+    if (vertex >= num_vertices + added_names.size()) {
+        string message = "vertex " + to_string(vertex) +
+                         " does not exist in the frozen collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_song
+ * @purpose: look up the name of the edge stored in an adjacency slot of the
+ *           frozen graph
+ *
+ * @parameters: a size_t, an index into adjacency
+ * @returns: a string, the song that edge represents
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string CollabGraph::get_song(size_t slot) const {
+    return string(get_song_view(slot));
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_song_view
+ * @purpose: look up the name of the edge stored in an adjacency slot of the
+ *           frozen graph, without copying it
+ *
+ * @parameters: a size_t, an index into adjacency
+ * @returns: a string_view of the song that edge represents
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string_view CollabGraph::get_song_view(size_t slot) const {
+    uint32_t song = adjacency_songs[slot];
+    return string_view(song_chars + song_offsets[song],
+                       song_offsets[song + 1] - song_offsets[song]);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: find_slot
+ * @purpose: find the slot of the edge between two vertices of the frozen
+ *           graph by binary search over the first vertex's neighbors
+ *
+ * @parameters: two VertexIds, which should be in the frozen graph
+ * @returns: a size_t, the edge's slot in adjacency and adjacency_songs,
+ *           or NO_SLOT if there is no edge connecting them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t CollabGraph::find_slot(VertexId v1, VertexId v2) const {
+    const VertexId* first = adjacency + offsets[v1];
+    const VertexId* last  = adjacency + offsets[v1 + 1];
+
+    if (edge_order == nullptr) {
+        const VertexId* found = lower_bound(first, last, v2);
+        if (found == last or *found != v2) return NO_SLOT;
+        return found - adjacency;
+    }
+
+    // The list keeps its own order; edge_order sorts its positions
+    const uint32_t* order_first = edge_order + offsets[v1];
+    const uint32_t* order_last  = edge_order + offsets[v1 + 1];
+    const uint32_t* found = lower_bound(
+        order_first, order_last, v2,
+        [first](uint32_t pos, VertexId v) { return first[pos] < v; });
+    if (found == order_last or first[*found] != v2) return NO_SLOT;
+    return offsets[v1] + *found;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_neighbor_song
+ * @purpose: look up the name of an edge of the frozen graph by its
+ *           position in one endpoint's list of neighbors
+ *
+ * @parameters: 1) a VertexId, which should be in the frozen graph
+ *              2) a size_t, the position of the edge in its neighbors
+ * @returns: a string_view of the song that edge represents
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string_view CollabGraph::get_neighbor_song(VertexId vertex,
+                                           size_t   index) const {
+    if (vertex < changed.size() and changed[vertex] != NO_CHANGE) {
+        return changed_lists[changed[vertex]].songs[index];
+    }
+    return get_song_view(offsets[vertex] + index);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: find_edge_song
+ * @purpose: find the edge between two vertices of the frozen graph, whether
+ *           it is in the image or was added since
+ *
+ * @parameters: 1) two VertexIds, which should be in the frozen graph
+ *              2) a string_view reference, set to the name of the edge
+ * @returns: a bool, true iff there is an edge connecting the vertices
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::find_edge_song(VertexId v1, VertexId v2,
+                                 string_view& song) const {
+    if (v1 < changed.size() and changed[v1] != NO_CHANGE) {
+        const ChangedList& list  = changed_lists[changed[v1]];
+        auto               first = list.neighbors.begin();
+        auto               last  = list.neighbors.end();
+
+        // A changed list is only sorted if the image's lists are
+        auto found = edge_order == nullptr ? lower_bound(first, last, v2)
+                                           : find(first, last, v2);
+        if (found == last or *found != v2) return false;
+
+        song = list.songs[found - first];
+        return true;
+    }
+
+    size_t slot = find_slot(v1, v2);
+    if (slot == NO_SLOT) return false;
+
+    song = get_song_view(slot);
+    return true;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: get_song_artists
+ * @purpose: list every artist of the frozen graph that has a song
+ *
+ * @parameters: 1) a string_view, the name of the song
+ *              2) a vector<VertexId> reference, set to the song's artists
+ * @returns: a bool, true iff any artist has the song
+ *
+ * @notes: the artists are the song's postings in the catalog, in ascending
+ *         order, followed by the artists given it since the graph was
+ *         frozen, so no adjacency list is looked at. A graph frozen from
+ *         Artists has an empty catalog, and so knows only the added songs
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool CollabGraph::get_song_artists(string_view       song,
+                                   vector<VertexId>& artists) const {
+    artists.clear();
+    if (not frozen) return false;
+
+    uint32_t id = find_catalog_song(song);
+    if (id != NO_SONG) {
+        artists.assign(posting_artists + posting_offsets[id],
+                       posting_artists + posting_offsets[id + 1]);
+    } else {
+        auto added = added_song_ids.find(song);
+        if (added == added_song_ids.end()) return false;
+        id = added->second;
+    }
+
+    auto extra = added_postings.find(id);
+    if (extra != added_postings.end()) {
+        for (const AddedPosting& posting : extra->second) {
+            artists.push_back(posting.artist);
+        }
+    }
+
+    return not artists.empty();
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: find_catalog_song
+ * @purpose: look a song up in the frozen image's catalog
+ *
+ * @parameters: a string_view, the name of a song
+ * @returns: a uint32_t, the song's index in the catalog, or NO_SONG if the
+ *           data the graph was built from never lists it
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint32_t CollabGraph::find_catalog_song(string_view song) const {
+    STATS_COUNT(HASH_LOOKUPS, 1);
+
+    uint64_t bucket = fnv1a(song.data(), song.size()) & catalog_mask;
+
+    while (catalog_index[bucket] != NO_SONG) {
+        uint32_t c = catalog_index[bucket];
+        if (string_view(catalog_chars + catalog_offsets[c],
+                        catalog_offsets[c + 1] - catalog_offsets[c]) == song) {
+            return c;
+        }
+        bucket = (bucket + 1) & catalog_mask;
+    }
+
+    return NO_SONG;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: find_position
+ * @purpose: find where a song first appears in an artist's list, whether
+ *           the artist had it in the image or was given it since
+ *
+ * @parameters: 1) a VertexId, the artist
+ *              2) a string_view, the song
+ * @returns: a uint64_t, the position, or UINT64_MAX if the artist does not
+ *           have the song
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t CollabGraph::find_position(VertexId artist, string_view song) const {
+    uint32_t id = find_catalog_song(song);
+
+    if (id != NO_SONG) {
+        const VertexId* first = posting_artists + posting_offsets[id];
+        const VertexId* last  = posting_artists + posting_offsets[id + 1];
+        const VertexId* found = lower_bound(first, last, artist);
+        if (found != last and *found == artist) {
+            return posting_positions[found - posting_artists];
+        }
+    } else {
+        auto added = added_song_ids.find(song);
+        if (added == added_song_ids.end()) return UINT64_MAX;
+        id = added->second;
+    }
+
+    auto extra = added_postings.find(id);
+    if (extra != added_postings.end()) {
+        for (const AddedPosting& posting : extra->second) {
+            if (posting.artist == artist) return posting.position;
+        }
+    }
+
+    return UINT64_MAX;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: add_posting
+ * @purpose: record that an artist of the frozen graph has a song, and
+ *           connect it to the song's other artists
+ *
+ * @parameters: 1) a VertexId, the artist
+ *              2) a string_view, the song
+ * @returns: none
+ *
+ * @notes: 1) the song's artists are its postings in the catalog followed by
+ *            the artists given it since, so the rest of the graph is never
+ *            looked at. See add_song
+ *         2) as when the graph is built, the edge between artists i < j is
+ *            named by the first song in i's list that j also has. The song
+ *            goes at the end of this artist's list, so it only renames an
+ *            edge to an earlier artist that lists it before the song the
+ *            edge has now
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::add_posting(VertexId artist, string_view song) {
+    uint32_t id = find_catalog_song(song);
+    if (id == NO_SONG) {
+        auto added = added_song_ids.find(song);
+        if (added != added_song_ids.end()) {
+            id = added->second;
+        } else {
+            id = catalog_songs + added_songs.size();
+            added_songs.push_back(string(song));
+            added_song_ids.insert({added_songs.back(), id});
+        }
+    }
+
+    vector<AddedPosting> partners;
+    string_view          name;
+    if (id < catalog_songs) {
+        for (uint64_t p = posting_offsets[id]; p < posting_offsets[id + 1];
+             p++) {
+            partners.push_back({posting_artists[p], posting_positions[p]});
+        }
+        name = string_view(catalog_chars + catalog_offsets[id],
+                           catalog_offsets[id + 1] - catalog_offsets[id]);
+    } else {
+        name = added_songs[id - catalog_songs];
+    }
+
+    auto extra = added_postings.find(id);
+    if (extra != added_postings.end()) {
+        partners.insert(partners.end(), extra->second.begin(),
+                        extra->second.end());
+    }
+
+    // Only the first time an artist lists a song can connect it
+    for (const AddedPosting& partner : partners) {
+        if (partner.artist == artist) return;
+    }
+
+    num_landmarks = 0;
+
+    string_view current;
+    for (const AddedPosting& partner : partners) {
+        if (name.empty()) break;
+
+        if (not find_edge_song(artist, partner.artist, current) or
+            (partner.artist < artist and
+             partner.position < find_position(partner.artist, current))) {
+            set_frozen_edge(artist, partner.artist, name);
+        }
+    }
+
+    added_postings[id].push_back({artist, next_position++});
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: set_frozen_edge
+ * @purpose: connect two vertices of the frozen graph, or rename the edge
+ *           that connects them
+ *
+ * @parameters: 1) two VertexIds, which should be in the frozen graph
+ *              2) a string_view of the song that names the edge, which must
+ *                 live as long as the graph stays frozen
+ * @returns: none
+ *
+ * @notes: each endpoint's list is copied out of the image the first time it
+ *         changes, and a new neighbor goes where the sorted order puts it
+ *         (at the end if the image's lists are not sorted)
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::set_frozen_edge(VertexId v1, VertexId v2,
+                                  string_view song) {
+    const VertexId ends[2][2] = {{v1, v2}, {v2, v1}};
+    bool           added      = false;
+
+    for (const VertexId* end : ends) {
+        ChangedList& list  = changed_list(end[0]);
+        auto         first = list.neighbors.begin();
+        auto         last  = list.neighbors.end();
+        auto         found = edge_order == nullptr
+                                 ? lower_bound(first, last, end[1])
+                                 : find(first, last, end[1]);
+        size_t       position = found - first;
+
+        if (found == last or *found != end[1]) {
+            list.neighbors.insert(found, end[1]);
+            list.songs.insert(list.songs.begin() + position, song);
+            added = true;
+        } else {
+            list.songs[position] = song;
+        }
+    }
+
+    if (added) added_slots += 2;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: changed_list
+ * @purpose: retrieve the list of neighbors that a vertex of the frozen graph
+ *           is given once it changes, making it on first use
+ *
+ * @parameters: a VertexId, which should be in the frozen graph
+ * @returns: a reference to the vertex's ChangedList, which starts as a copy
+ *           of its list in the image (or empty, for an added artist); it is
+ *           invalidated by the next call
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::ChangedList& CollabGraph::changed_list(VertexId vertex) {
+    if (changed.size() < vertex_count()) {
+        changed.resize(vertex_count(), NO_CHANGE);
+    }
+
+    if (changed[vertex] == NO_CHANGE) {
+        changed[vertex] = changed_lists.size();
+        changed_lists.push_back(ChangedList());
+
+        if (vertex < num_vertices) {
+            ChangedList& list = changed_lists.back();
+            list.neighbors.assign(adjacency + offsets[vertex],
+                                  adjacency + offsets[vertex + 1]);
+            for (size_t slot = offsets[vertex]; slot < offsets[vertex + 1];
+                 slot++) {
+                list.songs.push_back(get_song_view(slot));
+            }
+        }
+    }
+
+    return changed_lists[changed[vertex]];
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: choose_landmarks
+ * @purpose: choose landmarks for build_landmarks, taking the vertices with
+ *           the most neighbors first but skipping the neighbors of a
+ *           landmark already chosen, whose distances would be nearly the
+ *           same as that landmark's
+ *
+ * @parameters: 1) a size_t, the most landmarks to choose
+ *              2) a vector of VertexIds, filled with the landmarks
+ * @returns: none
+ *
+ * @notes: vertices with no neighbors are never chosen, so fewer than count
+ *         landmarks are chosen if every vertex with a neighbor has been
+ *         chosen or skipped
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::choose_landmarks(size_t            count,
+                                   vector<VertexId>& chosen) const {
+    vector<VertexId> by_degree(num_vertices);
+    for (VertexId v = 0; v < num_vertices; v++) by_degree[v] = v;
+
+    // Ties go to the smaller id, so the choice is the same every time
+    stable_sort(by_degree.begin(), by_degree.end(),
+                [this](VertexId a, VertexId b) {
+                    return offsets[a + 1] - offsets[a] >
+                           offsets[b + 1] - offsets[b];
+                });
+
+    vector<bool> skipped(num_vertices, false);
+    for (VertexId v : by_degree) {
+        if (chosen.size() == count or offsets[v + 1] == offsets[v]) break;
+        if (skipped[v]) continue;
+
+        chosen.push_back(v);
+        for (uint64_t slot = offsets[v]; slot < offsets[v + 1]; slot++) {
+            skipped[adjacency[slot]] = true;
+        }
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: frozen_metadata
+ * @purpose: retrieve the graph's own traversal metadata, sizing it for the
+ *           frozen graph the first time it is needed
+ *
+ * @parameters: none
+ * @returns: a reference to the graph's SearchState
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::SearchState& CollabGraph::frozen_metadata() const {
+    if (metadata.size() != vertex_count()) metadata.clear(vertex_count());
+    return metadata;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: layout_sections
+ * @purpose: compute where each section of a frozen image starts
+ *
+ * @parameters: 1) the header describing the image
+ *              2) an array filled with each section's byte offset from the
+ *                 start of the image, in the order listed in CollabGraph.h
+ * @returns: the total size of the image in bytes, a multiple of 8
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t CollabGraph::layout_sections(const SnapshotHeader& header,
+                                      uint64_t at[NUM_SECTIONS]) {
+    uint64_t sizes[NUM_SECTIONS] = {
+        (header.num_vertices + 1) * sizeof(uint64_t),
+        header.num_slots * sizeof(VertexId),
+        header.num_slots * sizeof(uint32_t),
+        (header.num_vertices + 1) * sizeof(uint64_t),
+        (header.num_songs + 1) * sizeof(uint64_t),
+        header.index_size * sizeof(VertexId),
+        header.name_bytes,
+        header.song_bytes,
+        header.order_slots * sizeof(uint32_t),
+        (header.catalog_songs + 1) * sizeof(uint64_t),
+        header.catalog_bytes,
+        header.catalog_index_size * sizeof(uint32_t),
+        (header.catalog_songs + 1) * sizeof(uint64_t),
+        header.num_postings * sizeof(VertexId),
+        header.num_postings * sizeof(uint32_t),
+        header.num_landmarks * sizeof(VertexId),
+        header.num_vertices * header.num_landmarks};
+
+    uint64_t position = (sizeof(SnapshotHeader) + 7) / 8 * 8;
+    for (int i = 0; i < NUM_SECTIONS; i++) {
+        at[i]    = position;
+        position = (position + sizes[i] + 7) / 8 * 8;
+    }
+
+    return position;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: allocate_image
+ * @purpose: allocate a zeroed frozen image for the given section sizes
+ *
+ * @parameters: 1) a header whose num_vertices, num_slots, num_songs,
+ *                 name_bytes, song_bytes, catalog_songs, catalog_bytes and
+ *                 num_postings are filled in; the rest of it is filled in
+ *                 here
+ *              2) an array filled with each section's byte offset
+ * @returns: a pointer to the start of the image, which the caller fills
+ *           in every section of except the two indexes before seal_image
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+char* CollabGraph::allocate_image(SnapshotHeader& header,
+                                  uint64_t        at[NUM_SECTIONS]) {
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version    = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+
+    // Keep at least half of the name index empty so probes stay short
+    header.index_size = 1;
+    while (header.index_size < 2 * header.num_vertices) {
+        header.index_size *= 2;
+    }
+    header.catalog_index_size = 1;
+    while (header.catalog_index_size < 2 * header.catalog_songs) {
+        header.catalog_index_size *= 2;
+    }
+
+    header.total_size = layout_sections(header, at);
+    uint64_t* words   = new uint64_t[header.total_size / sizeof(uint64_t)]();
+    image.reset(words, default_delete<uint64_t[]>());
+
+    return reinterpret_cast<char*>(words);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: write_song_table
+ * @purpose: renumber the songs of an image being built in the order a walk
+ *           over the adjacency lists first meets them, which is the order
+ *           freeze numbers them in, and write them out as its song table
+ *
+ * @parameters: 1) the start of the image and its section offsets
+ *              2) the number of adjacency slots
+ *              3) the songs that adjacency_songs currently indexes into
+ * @returns: none
+ *
+ * @notes: the song table's section sizes must already count exactly the
+ *         songs that are used, which makes every way of building a graph
+ *         produce the same image
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::write_song_table(char* base, const uint64_t at[NUM_SECTIONS],
+                                   uint64_t                   num_slots,
+                                   const vector<string_view>& songs) {
+    uint32_t* adjacency_songs = reinterpret_cast<uint32_t*>(base + at[2]);
+    uint64_t* song_offsets    = reinterpret_cast<uint64_t*>(base + at[4]);
+    char*     song_chars      = base + at[7];
+
+    vector<uint32_t> labels(songs.size(), UINT32_MAX);
+    uint32_t         next_label = 0;
+
+    for (uint64_t slot = 0; slot < num_slots; slot++) {
+        uint32_t& song = adjacency_songs[slot];
+
+        if (labels[song] == UINT32_MAX) {
+            string_view name = songs[song];
+            memcpy(song_chars + song_offsets[next_label], name.data(),
+                   name.size());
+            song_offsets[next_label + 1] =
+                song_offsets[next_label] + name.size();
+            labels[song] = next_label++;
+        }
+        song = labels[song];
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: write_catalog_names
+ * @purpose: write the names of the songs in the catalog of an image being
+ *           built
+ *
+ * @parameters: 1) the start of the image and its section offsets
+ *              2) the songs, under the ids the builder gave them
+ *              3) the id of each song in catalog order
+ * @returns: none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::write_catalog_names(char*          base,
+                                      const uint64_t at[NUM_SECTIONS],
+                                      const vector<string_view>& songs,
+                                      const vector<uint32_t>&    order) {
+    uint64_t* catalog_offsets = reinterpret_cast<uint64_t*>(base + at[9]);
+    char*     catalog_chars   = base + at[10];
+
+    for (uint32_t c = 0; c < order.size(); c++) {
+        string_view name = songs[order[c]];
+        memcpy(catalog_chars + catalog_offsets[c], name.data(), name.size());
+        catalog_offsets[c + 1] = catalog_offsets[c] + name.size();
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: seal_image
+ * @purpose: finish an image from allocate_image by building its name and
+ *           catalog indexes and, if the header asks for one, its
+ *           edge_order, then make it the frozen graph
+ *
+ * @parameters: the header and section offsets given by allocate_image
+ * @returns: none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::seal_image(SnapshotHeader& header,
+                             const uint64_t  at[NUM_SECTIONS]) {
+    char*           base  = static_cast<char*>(image.get());
+    const uint64_t* names = reinterpret_cast<const uint64_t*>(base + at[3]);
+    const char*     chars = base + at[6];
+    VertexId*       index = reinterpret_cast<VertexId*>(base + at[5]);
+    uint64_t        mask  = header.index_size - 1;
+
+    fill(index, index + header.index_size, NO_VERTEX);
+    for (VertexId v = 0; v < header.num_vertices; v++) {
+        uint64_t bucket =
+            fnv1a(chars + names[v], names[v + 1] - names[v]) & mask;
+        while (index[bucket] != NO_VERTEX) bucket = (bucket + 1) & mask;
+        index[bucket] = v;
+    }
+
+    const uint64_t* songs   = reinterpret_cast<const uint64_t*>(base + at[9]);
+    const char*     letters = base + at[10];
+    uint32_t*       catalog = reinterpret_cast<uint32_t*>(base + at[11]);
+    mask                    = header.catalog_index_size - 1;
+
+    fill(catalog, catalog + header.catalog_index_size, NO_SONG);
+    for (uint32_t c = 0; c < header.catalog_songs; c++) {
+        uint64_t bucket =
+            fnv1a(letters + songs[c], songs[c + 1] - songs[c]) & mask;
+        while (catalog[bucket] != NO_SONG) bucket = (bucket + 1) & mask;
+        catalog[bucket] = c;
+    }
+
+    if (header.order_slots != 0) {
+        const uint64_t* starts = reinterpret_cast<const uint64_t*>(base + at[0]);
+        const VertexId* lists  = reinterpret_cast<const VertexId*>(base + at[1]);
+        uint32_t*       order  = reinterpret_cast<uint32_t*>(base + at[8]);
+
+        for (VertexId v = 0; v < header.num_vertices; v++) {
+            const VertexId* list  = lists + starts[v];
+            uint32_t*       first = order + starts[v];
+            uint32_t*       last  = order + starts[v + 1];
+
+            for (uint32_t* pos = first; pos != last; pos++) {
+                *pos = pos - first;
+            }
+            sort(first, last, [list](uint32_t a, uint32_t b) {
+                return list[a] < list[b];
+            });
+        }
+    }
+
+    // The checksum is only needed in files, so save_snapshot computes it
+    memcpy(base, &header, sizeof(header));
+
+    attach(base, header.total_size, false);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: attach
+ * @purpose: check a frozen image and point the graph's views into it
+ *
+ * @parameters: 1) the start of the image, which must be 8-byte aligned and
+ *                 outlive the frozen graph
+ *              2) the number of bytes available at that address
+ *              3) a bool, true to also verify the checksum, which reads
+ *                 the whole image
+ * @returns: none
+ *
+ * @notes: throws a runtime_error if the image is not a snapshot of this
+ *         version and byte order, or if its sizes do not add up. Apart
+ *         from the optional checksum every check is O(1); the ids and
+ *         offsets inside the sections are trusted, so an image from a file
+ *         must also pass check_sections
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::attach(const char* base, size_t size, bool verify) {
+    SnapshotHeader header;
+    uint64_t       at[NUM_SECTIONS];
+
+    if (size < sizeof(header)) {
+        throw runtime_error("snapshot is too small to have a header");
+    }
+    memcpy(&header, base, sizeof(header));
+
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("not a collaboration graph snapshot");
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw runtime_error("unsupported snapshot version " +
+                            to_string(header.version));
+    }
+    if (header.byte_order != SNAPSHOT_BYTE_ORDER) {
+        throw runtime_error("snapshot was written with another byte order");
+    }
+    if (header.num_vertices >= NO_VERTEX or header.index_size == 0 or
+        (header.index_size & (header.index_size - 1)) != 0 or
+        header.index_size <= header.num_vertices or
+        (header.order_slots != 0 and
+         header.order_slots != header.num_slots) or
+        header.num_landmarks > header.num_vertices or
+        header.catalog_songs >= NO_SONG or header.catalog_index_size == 0 or
+        (header.catalog_index_size & (header.catalog_index_size - 1)) != 0 or
+        header.catalog_index_size <= header.catalog_songs or
+        layout_sections(header, at) != header.total_size or
+        header.total_size != size) {
+        throw runtime_error("snapshot sizes are inconsistent");
+    }
+
+    const uint64_t* last_offsets =
+        reinterpret_cast<const uint64_t*>(base + at[0]);
+    const uint64_t* last_names = reinterpret_cast<const uint64_t*>(base + at[3]);
+    const uint64_t* last_songs = reinterpret_cast<const uint64_t*>(base + at[4]);
+    const uint64_t* last_catalog =
+        reinterpret_cast<const uint64_t*>(base + at[9]);
+    const uint64_t* last_postings =
+        reinterpret_cast<const uint64_t*>(base + at[12]);
+    if (last_offsets[header.num_vertices] != header.num_slots or
+        last_names[header.num_vertices] != header.name_bytes or
+        last_songs[header.num_songs] != header.song_bytes or
+        last_catalog[header.catalog_songs] != header.catalog_bytes or
+        last_postings[header.catalog_songs] != header.num_postings) {
+        throw runtime_error("snapshot sections are inconsistent");
+    }
+
+    if (verify and fnv1a(base + sizeof(header), size - sizeof(header)) !=
+                       header.checksum) {
+        throw runtime_error("snapshot checksum does not match");
+    }
+
+    image_base         = base;
+    image_size         = size;
+    num_vertices       = header.num_vertices;
+    index_mask         = header.index_size - 1;
+    offsets            = reinterpret_cast<const uint64_t*>(base + at[0]);
+    adjacency          = reinterpret_cast<const VertexId*>(base + at[1]);
+    adjacency_songs    = reinterpret_cast<const uint32_t*>(base + at[2]);
+    name_offsets       = reinterpret_cast<const uint64_t*>(base + at[3]);
+    song_offsets       = reinterpret_cast<const uint64_t*>(base + at[4]);
+    name_index         = reinterpret_cast<const VertexId*>(base + at[5]);
+    name_chars         = base + at[6];
+    song_chars         = base + at[7];
+    edge_order         = header.order_slots == 0
+                             ? nullptr
+                             : reinterpret_cast<const uint32_t*>(base + at[8]);
+    catalog_songs      = header.catalog_songs;
+    catalog_mask       = header.catalog_index_size - 1;
+    catalog_offsets    = reinterpret_cast<const uint64_t*>(base + at[9]);
+    catalog_chars      = base + at[10];
+    catalog_index      = reinterpret_cast<const uint32_t*>(base + at[11]);
+    posting_offsets    = reinterpret_cast<const uint64_t*>(base + at[12]);
+    posting_artists    = reinterpret_cast<const VertexId*>(base + at[13]);
+    posting_positions  = reinterpret_cast<const uint32_t*>(base + at[14]);
+    num_landmarks      = header.num_landmarks;
+    landmarks          = reinterpret_cast<const VertexId*>(base + at[15]);
+    landmark_distances = reinterpret_cast<const uint8_t*>(base + at[16]);
+    metadata           = SearchState();
+    frozen             = true;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: check_sections
+ * @purpose: check that every id and offset in an attached image stays
+ *           within the image, so no query can read outside it
+ *
+ * @parameters: the start of an image that attach has accepted
+ * @returns: none
+ *
+ * @notes: 1) throws a runtime_error naming the first section found out of
+ *            range. Reads every section but the name and song characters
+ *            once, O(V + E) in all
+ *         2) only bounds are checked; a file that passes but was not
+ *            written by save_snapshot may still give wrong answers, which
+ *            the checksum is for
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::check_sections(const char* base) {
+    SnapshotHeader header;
+    uint64_t       at[NUM_SECTIONS];
+
+    memcpy(&header, base, sizeof(header));
+    layout_sections(header, at);
+
+    auto offsets_at = [base, &at](int section) {
+        return reinterpret_cast<const uint64_t*>(base + at[section]);
+    };
+    auto ids_at = [base, &at](int section) {
+        return reinterpret_cast<const uint32_t*>(base + at[section]);
+    };
+    const uint64_t* starts   = offsets_at(0);
+    const uint64_t* names    = offsets_at(3);
+    const uint64_t* labels   = offsets_at(4);
+    const uint64_t* titles   = offsets_at(9);
+    const uint64_t* postings = offsets_at(12);
+    size_t          count    = header.num_vertices;
+
+    if (not ascending(starts, count) or
+        not in_range(ids_at(1), header.num_slots, count)) {
+        throw runtime_error("snapshot adjacency lists are out of range");
+    }
+    if (not ascending(labels, header.num_songs) or
+        not in_range(ids_at(2), header.num_slots, header.num_songs)) {
+        throw runtime_error("snapshot edge songs are out of range");
+    }
+    if (not ascending(names, count) or
+        not in_range(ids_at(5), header.index_size, count, NO_VERTEX)) {
+        throw runtime_error("snapshot artist names are out of range");
+    }
+    if (header.order_slots != 0) {
+        const uint32_t* order = ids_at(8);
+        for (VertexId v = 0; v < count; v++) {
+            uint64_t degree = starts[v + 1] - starts[v];
+            if (not in_range(order + starts[v], degree, degree)) {
+                throw runtime_error("snapshot edge order is out of range");
+            }
+        }
+    }
+    if (not ascending(titles, header.catalog_songs) or
+        not in_range(ids_at(11), header.catalog_index_size,
+                     header.catalog_songs, NO_SONG) or
+        not ascending(postings, header.catalog_songs) or
+        not in_range(ids_at(13), header.num_postings, count)) {
+        throw runtime_error("snapshot song catalog is out of range");
+    }
+    if (not in_range(ids_at(15), header.num_landmarks, count)) {
+        throw runtime_error("snapshot landmarks are out of range");
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: print_name / print_degree
+ * @purpose: look up a vertex for print_graph, in whichever of the frozen
+ *           and unfrozen graphs is in use
+ *
+ * @parameters: 1) the unfrozen graph's vertices, as print_graph found them
+ *              2) a VertexId, which should be in the graph
+ * @returns: the vertex's name / the number of its neighbors
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string_view CollabGraph::print_name(const PrintSource& source,
+                                    VertexId           vertex) const {
+    return frozen ? get_vertex_name(vertex) : source.names[vertex];
+}
+
+size_t CollabGraph::print_degree(const PrintSource& source,
+                                 VertexId           vertex) const {
+    if (frozen) return neighbors_end(vertex) - neighbors_begin(vertex);
+    return source.vertices[vertex]->neighbors.size();
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: print_line
+ * @purpose: find the pieces of one print_graph line
+ *
+ * @parameters: 1) the unfrozen graph's vertices, as print_graph found them
+ *              2) a VertexId, which should be in the graph
+ *              3) the position of an edge in its neighbors
+ * @returns: the line without its opening quote, in seven pieces; the last
+ *           is the empty line after the vertex's last neighbor, or empty
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph::JoinedText CollabGraph::print_line(const PrintSource& source,
+                                                VertexId           vertex,
+                                                size_t index) const {
+    string_view neighbor, song;
+    if (frozen) {
+        neighbor = get_vertex_name(neighbors_begin(vertex)[index]);
+        song     = get_neighbor_song(vertex, index);
+    } else {
+        const Edge& edge = source.vertices[vertex]->neighbors[index];
+        neighbor         = source.names[edge.neighbor->id];
+        song             = edge.song;
+    }
+
+    bool last = index + 1 == print_degree(source, vertex);
+    return JoinedText{{print_name(source, vertex), PRINT_WITH, neighbor,
+                       PRINT_IN, song, PRINT_END, last ? "\n" : ""},
+                      7};
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: print_group
+ * @purpose: find the vertices whose lines print_graph has to sort together
+ *
+ * @parameters: the vertices left to print, in print_graph's order
+ * @returns: how many of them, from the first, are in its group: those
+ *           whose name and PRINT_WITH begin with the first one's name and
+ *           PRINT_WITH, so that their lines can sort between its lines
+ * @notes: a group is only more than one vertex when a name contains
+ *         PRINT_WITH; any other vertex's lines all sort after the lines
+ *         of the vertices before it
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t CollabGraph::print_group(const PrintSource& source,
+                                const VertexId*    first,
+                                const VertexId*    last) const {
+    JoinedText      start = {{print_name(source, *first), PRINT_WITH}, 2};
+    const VertexId* v     = first + 1;
+    for (; v < last; v++) {
+        JoinedText key = {{print_name(source, *v), PRINT_WITH}, 2};
+        if (compare_joined(start, key, 0) != 0 or
+            joined_size(start, 0) > joined_size(key, 0)) {
+            break;
+        }
+    }
+    return v - first;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: print_lines
+ * @purpose: format the lines of some vertices in print_graph's order
+ *
+ * @parameters: 1) the unfrozen graph's vertices, as print_graph found them
+ *              2) the vertices, a range of whole groups in print_graph's
+ *                 order
+ *              3) a string reference, where the lines are appended
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void CollabGraph::print_lines(const PrintSource& source,
+                              const VertexId* first, const VertexId* last,
+                              string& text) const {
+    vector<JoinedText> lines;
+    while (first < last) {
+        size_t group = print_group(source, first, last);
+
+        lines.clear();
+        for (const VertexId* v = first; v < first + group; v++) {
+            size_t degree = print_degree(source, *v);
+            for (size_t i = 0; i < degree; i++) {
+                lines.push_back(print_line(source, *v, i));
+            }
+        }
+
+        // The lines of one vertex all begin with the same two pieces
+        int skip = group == 1 ? 2 : 0;
+        sort(lines.begin(), lines.end(),
+             [skip](const JoinedText& a, const JoinedText& b) {
+                 int c = compare_joined(a, b, skip);
+                 return c < 0 or (c == 0 and joined_size(a, skip) <
+                                                 joined_size(b, skip));
+             });
+
+        for (const JoinedText& line : lines) {
+            text += '"';
+            for (int p = 0; p < line.count; p++) text += line.pieces[p];
+        }
+        first += group;
+    }
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: compare_joined / joined_size
+ * @purpose: compare and measure texts as if their pieces were joined
+ *
+ * @parameters: the texts, and how many of their first pieces to leave out
+ * @returns: compare_joined returns a negative number, zero or a positive
+ *           number as memcmp does, over as many bytes as the shorter text
+ *           has, so zero means one begins with the other; joined_size
+ *           returns the number of bytes
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int CollabGraph::compare_joined(const JoinedText& a, const JoinedText& b,
+                                int skip) {
+    int    i = skip, j = skip;
+    size_t x = 0, y = 0; // how far into a.pieces[i] and b.pieces[j]
+
+    while (i < a.count and j < b.count) {
+        size_t n = min(a.pieces[i].size() - x, b.pieces[j].size() - y);
+        if (n > 0) {
+            int c = memcmp(a.pieces[i].data() + x, b.pieces[j].data() + y, n);
+            if (c != 0) return c;
+        }
+        x += n;
+        y += n;
+        if (x == a.pieces[i].size()) {
+            i++;
+            x = 0;
+        }
+        if (y == b.pieces[j].size()) {
+            j++;
+            y = 0;
+        }
+    }
+    return 0;
+}
+
+size_t CollabGraph::joined_size(const JoinedText& text, int skip) {
+    size_t size = 0;
+    for (int p = skip; p < text.count; p++) size += text.pieces[p].size();
+    return size;
 }
@@ -27,8 +27,14 @@
 #ifndef __COLLAB_GRAPH__
 #define __COLLAB_GRAPH__
 
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
 #include <stack>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -44,6 +50,44 @@ class CollabGraph {
 
 
     public:
+    /* Dense integer name of a vertex, valid once the graph is frozen */
+    typedef uint32_t VertexId;
+    static const VertexId NO_VERTEX = UINT32_MAX;
+
+    /* An upper bound on a distance that the landmarks cannot bound */
+    static const uint32_t NO_BOUND = UINT32_MAX;
+
+    /* Visited marks and predecessors for one traversal of a frozen graph,
+     * indexed by VertexId. Searching never modifies a frozen graph, so any
+     * number of threads can search it at once, each with its own
+     * SearchState. A vertex is marked iff marked == epoch, and has a
+     * predecessor iff stamped == epoch, so clearing only advances the epoch.
+     * A bitmap given to exclude marks its vertices too, until the next
+     * clear, without touching metadata.
+     */
+    class SearchState {
+        public:
+        void     clear(size_t num_vertices);
+        void     mark_vertex(VertexId vertex);
+        void     unmark_vertex(VertexId vertex);
+        bool     is_marked(VertexId vertex) const;
+        void     exclude(const uint64_t* bitmap);
+        void     set_predecessor(VertexId to, VertexId from);
+        VertexId get_predecessor(VertexId vertex) const;
+        size_t   size() const;
+        size_t   memory_footprint() const;
+
+        private:
+        struct Metadata {
+            uint32_t marked      = 0;
+            uint32_t stamped     = 0;
+            VertexId predecessor = NO_VERTEX;
+        };
+        std::vector<Metadata> metadata;
+        uint32_t              epoch    = 1;
+        const uint64_t*       excluded = nullptr;
+    };
+
     /* Nullary Constructor */
     CollabGraph();
 
@@ -52,8 +96,93 @@ class CollabGraph {
     CollabGraph(const CollabGraph& source);
     CollabGraph& operator=(const CollabGraph& rhs);
 
+    /* Moves, which take the other graph's memory and leave it empty */
+    CollabGraph(CollabGraph&& source) noexcept;
+    CollabGraph& operator=(CollabGraph&& rhs) noexcept;
+
+    /* Statistics gathered while building the graph */
+    struct BuildStats {
+        size_t artists          = 0;
+        size_t song_occurrences = 0;
+        size_t distinct_songs   = 0;
+        size_t postings_scanned = 0;
+        size_t edges            = 0;
+        double index_ms         = 0;
+        double edges_ms         = 0;
+    };
+
+    /* The artists of one piece of a data file, as views of its text.
+     * Artist a's songs are songs[song_offsets[a] .. song_offsets[a + 1])
+     */
+    struct Records {
+        std::vector<std::string_view> names;
+        std::vector<std::string_view> songs;
+        std::vector<uint64_t>         song_offsets = {0};
+    };
+
+    /* Builds a frozen graph one artist at a time, straight from a parser,
+     * without an Artist per record or the pointer-based graph. The result
+     * has the same vertices, edges and edge names as populate_graph
+     * followed by freeze. Names and songs are kept as string_views, so
+     * the text they refer to must outlive finish().
+     */
+    class Builder {
+        public:
+        Builder(CollabGraph& graph);
+        void add_artist(std::string_view                     name,
+                        const std::vector<std::string_view>& songs);
+        void finish();
+
+        private:
+        /* An artist that has a song, and where that song first appears
+         * in the artist's list
+         */
+        struct Posting {
+            VertexId artist;
+            uint32_t position;
+        };
+
+        /* An edge to an earlier artist, named by song id */
+        struct Collab {
+            VertexId partner;
+            uint32_t song;
+        };
+
+        /* The earliest song an earlier artist shares with the new one */
+        struct Claim {
+            uint32_t position;
+            uint32_t song;
+        };
+
+        CollabGraph& target;
+
+        std::unordered_map<std::string_view, VertexId> ids;
+        std::unordered_map<std::string_view, uint32_t> song_ids;
+        std::vector<std::string_view>                  song_names;
+        std::vector<std::vector<Posting>>              postings;
+        std::vector<VertexId>                          seen_by;
+
+        // Scratch space for the earlier partners of the artist being added
+        std::vector<VertexId> claimed_by;
+        std::vector<Claim>    claims;
+        std::vector<VertexId> partners;
+
+        // Artist v's edges to earlier artists are
+        // collabs[collab_offsets[v] .. collab_offsets[v + 1])
+        std::string           name_chars;
+        std::vector<uint64_t> name_offsets;
+        std::vector<Collab>   collabs;
+        std::vector<uint64_t> collab_offsets;
+
+        BuildStats stats;
+    };
+
     /* Mutators */
     void populate_graph(const std::vector<Artist>& artists);
+    void populate_graph(const std::vector<Artist>& artists,
+                        const std::vector<std::vector<std::string>>& songs);
+    void populate_graph(const std::vector<Records>& chunks,
+                        unsigned                    num_threads);
     void insert_vertex(const Artist& artist);
     void insert_edge(const Artist& a1, const Artist& a2,
                      const std::string& song);
@@ -70,36 +199,311 @@ class CollabGraph {
     std::vector<Artist> get_vertex_neighbors(const Artist& artist) const;
     std::stack<Artist>  report_path(const Artist& source,
                                     const Artist& dest) const;
-    void                print_graph(std::ostream& out);
+    void                print_graph(std::ostream& out) const;
+    void                print_graph(std::ostream& out,
+                                    unsigned      num_threads) const;
+    const BuildStats&   get_build_stats() const;
+    void                print_build_stats(std::ostream& out) const;
+    size_t              memory_footprint() const;
+
+    /* Frozen (compressed sparse row) mode */
+    void             freeze();
+    bool             is_frozen() const;
+    size_t           vertex_count() const;
+    VertexId         get_vertex_id(std::string_view name) const;
+    std::string_view get_vertex_name(VertexId vertex) const;
+    const VertexId*  neighbors_begin(VertexId vertex) const;
+    const VertexId*  neighbors_end(VertexId vertex) const;
+    uint64_t         adjacency_size() const;
+    std::string      get_edge(VertexId v1, VertexId v2) const;
+    bool             get_edge(VertexId v1, VertexId v2,
+                              std::string& song) const;
+    bool             get_edge_view(VertexId v1, VertexId v2,
+                                   std::string_view& song) const;
+    void             mark_vertex(VertexId vertex);
+    bool             is_marked(VertexId vertex) const;
+    void             set_predecessor(VertexId to, VertexId from);
+    VertexId         get_predecessor(VertexId vertex) const;
+
+    /* Landmark distance oracle: every vertex's distance from a few
+     * landmark vertices, kept in the frozen image (and so in snapshots)
+     */
+    void     build_landmarks(size_t count, unsigned num_threads);
+    size_t   landmark_count() const;
+    VertexId get_landmark(size_t index) const;
+    bool     distance_bounds(VertexId v1, VertexId v2, uint32_t& lower,
+                             uint32_t& upper) const;
+
+    /* Artists and songs added to a frozen graph without rebuilding it.
+     * The song catalog in the frozen image lists every artist that has
+     * each song, so adding a song only visits its other artists.
+     */
+    void add_artist(std::string_view                     name,
+                    const std::vector<std::string_view>& songs);
+    void add_song(std::string_view artist, std::string_view song);
+    bool has_updates() const;
+    bool get_song_artists(std::string_view       song,
+                          std::vector<VertexId>& artists) const;
+
+    /* Binary snapshots of a frozen graph */
+    void        save_snapshot(const std::string& path) const;
+    void        load_snapshot(const std::string& path, bool verify);
+    static bool is_snapshot(const std::string& path);
 
     private:
     struct Vertex; // forward declare so can use Vertex in Edge struct
 
+    /* Vertices, their neighbor arrays and the characters of every song
+     * are allocated from the graph's arena, and are all freed at once
+     */
     struct Edge {
-        Edge(Vertex* n, std::string s) {
+        Edge(Vertex* n, std::string_view s) {
             neighbor = n;
             song     = s;
         };
-        Vertex*     neighbor;
-        std::string song;
+        Vertex*          neighbor;
+        std::string_view song;
     };
 
     struct Vertex {
-        Vertex(){};
-        Vertex(Artist a) { artist = a; };
+        Vertex(const Artist& a, std::pmr::memory_resource* arena)
+            : artist(a), neighbors(arena){};
 
-        Artist            artist;
-        std::vector<Edge> neighbors;
+        Artist                 artist;
+        std::pmr::vector<Edge> neighbors;
+        VertexId               id = NO_VERTEX;
 
         Vertex* predecessor = nullptr;
         bool    visited     = false;
     };
 
+    /* The unfrozen graph. Its arena owns all of its memory except what
+     * each Artist holds, so it is declared before the maps that allocate
+     * from it. An arena cannot be moved, so the whole graph lives on the
+     * heap and a move only takes the pointer to it.
+     */
+    struct UnfrozenGraph {
+        std::pmr::monotonic_buffer_resource                arena;
+        std::pmr::unordered_map<std::string_view, Vertex*> graph{&arena};
+
+        /* Every edge, keyed by the ids of its endpoints (see edge_key),
+         * mapped to its position in the neighbors of the endpoint with
+         * the smaller id
+         */
+        std::pmr::unordered_map<uint64_t, uint32_t> edge_index{&arena};
+    };
+
+
+    /* A frozen graph is one contiguous image: this header followed by its
+     * sections, each starting on an 8-byte boundary in the order
+     *     offsets, adjacency, adjacency_songs, name_offsets, song_offsets,
+     *     name_index, name_chars, song_chars, edge_order,
+     *     catalog_offsets, catalog_chars, catalog_index, posting_offsets,
+     *     posting_artists, posting_positions, landmarks, landmark_distances
+     * Snapshot files are exactly this image, so a mapped file is used
+     * in place. The checksum covers every byte after the header; it is
+     * only filled in when the image is saved.
+     */
+    struct SnapshotHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t total_size;
+        uint64_t checksum;
+        uint64_t num_vertices;
+        uint64_t num_slots;
+        uint64_t num_songs;
+        uint64_t name_bytes;
+        uint64_t song_bytes;
+        uint64_t index_size;
+        uint64_t order_slots;
+        uint64_t num_landmarks;
+        uint64_t catalog_songs;
+        uint64_t catalog_bytes;
+        uint64_t catalog_index_size;
+        uint64_t num_postings;
+    };
+    static const int NUM_SECTIONS = 17;
+
+    /* A vertex whose neighbors have changed since the graph was frozen:
+     * its whole list, with each edge's song beside it
+     */
+    struct ChangedList {
+        std::vector<VertexId>         neighbors;
+        std::vector<std::string_view> songs;
+    };
+
+    /* An artist given a song since the graph was frozen, and where the
+     * song is in its list; every such position is after the positions in
+     * the catalog
+     */
+    struct AddedPosting {
+        VertexId artist;
+        uint64_t position;
+    };
+
+    /* Where print_graph finds the unfrozen graph's vertices and names by
+     * id; both are empty when it prints the frozen graph
+     */
+    struct PrintSource {
+        std::vector<const Vertex*>    vertices;
+        std::vector<std::string_view> names;
+    };
+
+    /* Text made of up to seven pieces, compared as if they were joined, so
+     * print_graph can sort its lines without building them
+     */
+    struct JoinedText {
+        std::string_view pieces[7];
+        int              count = 0;
+    };
+
+    void             self_destruct();
+    void             detach();
+    void             free_vertices();
+    void             copy_vertices(const UnfrozenGraph& source);
+    void             copy_updates(const CollabGraph& source);
+    std::string_view arena_copy(std::string_view text);
+    Vertex*          find_vertex(const Artist& artist) const;
+    const Edge*      find_edge(const Vertex* v1, const Vertex* v2) const;
+    static uint64_t  edge_key(const Vertex* v1, const Vertex* v2);
+    void             enforce_mutable() const;
+    VertexId         frozen_id(const Artist& artist) const;
+    void             enforce_valid_id(VertexId vertex) const;
+    std::string      get_song(size_t slot) const;
+    std::string_view get_song_view(size_t slot) const;
+    std::string_view get_neighbor_song(VertexId vertex, size_t index) const;
+    bool             find_edge_song(VertexId v1, VertexId v2,
+                                    std::string_view& song) const;
+    uint32_t         find_catalog_song(std::string_view song) const;
+    uint64_t         find_position(VertexId         artist,
+                                   std::string_view song) const;
+    void             add_posting(VertexId artist, std::string_view song);
+    void             set_frozen_edge(VertexId v1, VertexId v2,
+                                     std::string_view song);
+    ChangedList&     changed_list(VertexId vertex);
+    void             choose_landmarks(size_t                 count,
+                                      std::vector<VertexId>& chosen) const;
+    size_t           find_slot(VertexId v1, VertexId v2) const;
+    SearchState&     frozen_metadata() const;
+    char*            allocate_image(SnapshotHeader& header,
+                                    uint64_t        at[NUM_SECTIONS]);
+    void             seal_image(SnapshotHeader& header,
+                                const uint64_t  at[NUM_SECTIONS]);
+    static void      write_song_table(
+        char* base, const uint64_t at[NUM_SECTIONS], uint64_t num_slots,
+        const std::vector<std::string_view>& songs);
+    static void      write_catalog_names(
+        char* base, const uint64_t at[NUM_SECTIONS],
+        const std::vector<std::string_view>& songs,
+        const std::vector<uint32_t>&         order);
+    void             attach(const char* base, size_t size, bool verify);
+    static void      check_sections(const char* base);
+    static uint64_t  layout_sections(const SnapshotHeader& header,
+                                     uint64_t at[NUM_SECTIONS]);
+    std::string_view print_name(const PrintSource& source,
+                                VertexId           vertex) const;
+    size_t           print_degree(const PrintSource& source,
+                                  VertexId           vertex) const;
+    JoinedText       print_line(const PrintSource& source, VertexId vertex,
+                                size_t index) const;
+    size_t           print_group(const PrintSource& source,
+                                 const VertexId* first,
+                                 const VertexId* last) const;
+    void             print_lines(const PrintSource& source,
+                                 const VertexId* first, const VertexId* last,
+                                 std::string& text) const;
+    static int       compare_joined(const JoinedText& a, const JoinedText& b,
+                                    int skip);
+    static size_t    joined_size(const JoinedText& text, int skip);
+
+    /* The unfrozen graph, null until its first vertex is inserted and
+     * again once it is frozen
+     */
+    std::unique_ptr<UnfrozenGraph> unfrozen;
+    BuildStats                     build_stats;
+
+    /* The frozen image, allocated (by freeze) or mapped (by
+     * load_snapshot), and freed or unmapped when the last graph using it
+     * lets go. An image is never written once it is sealed, so copies of
+     * a graph share it. image_base points to it.
+     */
+    bool                  frozen     = false;
+    std::shared_ptr<void> image;
+    const char*           image_base = nullptr;
+    size_t                image_size = 0;
+
+    /* Views of the frozen image. Vertex v's edges occupy slots
+     * [offsets[v], offsets[v + 1]) of adjacency and adjacency_songs. The
+     * name of vertex v and song s are the byte ranges
+     * [name_offsets[v], name_offsets[v + 1]) of name_chars and
+     * [song_offsets[s], song_offsets[s + 1]) of song_chars. name_index is
+     * an open-addressing hash table (linear probing) of VertexIds keyed by
+     * name, with NO_VERTEX marking empty buckets. Edges are found by binary
+     * search: every adjacency list is in ascending order unless edge_order
+     * is present, in which case edge_order[offsets[v] .. offsets[v + 1])
+     * lists the positions in v's list in ascending order of neighbor.
+     * The catalog lists every distinct song of the data, whether or not
+     * it names an edge: song c is the byte range [catalog_offsets[c],
+     * catalog_offsets[c + 1]) of catalog_chars, catalog_index hashes these
+     * names like name_index, and the artists that have song c are
+     * posting_artists[posting_offsets[c] .. posting_offsets[c + 1]), in
+     * ascending order, and posting_positions gives where song c first
+     * appears in each one's list. Vertex v's distance from landmarks[i] is
+     * landmark_distances[v * num_landmarks + i], so all of a vertex's
+     * distances are adjacent.
+     */
+    size_t          num_vertices       = 0;
+    size_t          index_mask         = 0;
+    const uint64_t* offsets            = nullptr;
+    const VertexId* adjacency          = nullptr;
+    const uint32_t* adjacency_songs    = nullptr;
+    const uint64_t* name_offsets       = nullptr;
+    const uint64_t* song_offsets       = nullptr;
+    const VertexId* name_index         = nullptr;
+    const char*     name_chars         = nullptr;
+    const char*     song_chars         = nullptr;
+    const uint32_t* edge_order         = nullptr;
+    size_t          catalog_songs      = 0;
+    size_t          catalog_mask       = 0;
+    const uint64_t* catalog_offsets    = nullptr;
+    const char*     catalog_chars      = nullptr;
+    const uint32_t* catalog_index      = nullptr;
+    const uint64_t* posting_offsets    = nullptr;
+    const VertexId* posting_artists    = nullptr;
+    const uint32_t* posting_positions  = nullptr;
+    size_t          num_landmarks      = 0;
+    const VertexId* landmarks          = nullptr;
+    const uint8_t*  landmark_distances = nullptr;
+
+    /* Updates made since the graph was frozen. Added artists take the ids
+     * after the image's, and are named by added_names. A vertex v with new
+     * edges has changed[v] != NO_CHANGE, and its neighbors are
+     * changed_lists[changed[v]] instead of its slots in adjacency. changed
+     * is empty until the first edge is added, and a changed list is in
+     * ascending order whenever the image's lists are. Songs missing from
+     * the catalog take the ids after its songs, and added_postings lists
+     * the artists given each song since, at increasing positions taken
+     * from next_position. Adding anything drops the landmarks, whose
+     * distances it could shorten.
+     */
+    static const uint32_t NO_CHANGE = UINT32_MAX;
+
+    std::deque<std::string>                                 added_names;
+    std::unordered_map<std::string_view, VertexId>          added_ids;
+    std::vector<uint32_t>                                   changed;
+    std::vector<ChangedList>                                changed_lists;
+    std::deque<std::string>                                 added_songs;
+    std::unordered_map<std::string_view, uint32_t>          added_song_ids;
+    std::unordered_map<uint32_t, std::vector<AddedPosting>> added_postings;
 
-    void self_destruct();
-    void enforce_valid_vertex(const Artist& artist) const;
+    uint64_t added_slots   = 0;
+    uint64_t next_position = UINT64_C(1) << 32;
 
-    std::unordered_map<std::string, Vertex*> graph;
+    /* Traversal metadata used by the frozen graph's own mark_vertex,
+     * set_predecessor, etc. It is only sized once it is first needed.
+     */
+    mutable SearchState metadata;
 };
 
 #endif /* __COLLAB_GRAPH__ */
@@ -0,0 +1,199 @@
+/*
+ * CopyBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures what copying and moving a CollabGraph costs. On one data file,
+ * such as one written by GraphGen, the graph is timed being:
+ *   1) copied and moved before it is frozen, with the same artists and
+ *      collaborations inserted one at a time, which is also timed
+ *   2) copied and moved once it is frozen, as SixDegrees loads it, when
+ *      copies share the frozen image
+ *   3) copied once songs and artists have been added to it
+ * Every copy is checked against its original with print_graph, and the
+ * original is checked again after its copies are changed.
+ *
+ * Usage: CopyBench dataFile [updates]
+ *
+ */
+
+#include "CollabGraph.h"
+#include "SixDegrees.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Cheap operations are repeated this many times to be timed
+static const size_t REPEATS = 1000;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: printed
+ * @purpose: prints a graph, to compare it with another
+ *
+ * @parameters: the graph
+ * @returns: everything print_graph printed
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static string printed(const CollabGraph &graph) {
+    ostringstream output;
+    graph.print_graph(output);
+    return output.str();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: timeCopy
+ * @purpose: copies a graph, timing the copy and checking it
+ *
+ * @parameters: the graph, its printed form, and whether the copy was the
+ *              same, which is cleared if it was not
+ * @returns: the time the copy took in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double timeCopy(const CollabGraph &graph, const string &expected,
+                       bool &same) {
+    Clock::time_point start = Clock::now();
+    CollabGraph copy(graph);
+    double copyMs = milliseconds(start);
+
+    same = same and printed(copy) == expected;
+    return copyMs;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: timeMoves
+ * @purpose: moves a graph into another and back, many times
+ *
+ * @parameters: the graph, its printed form, and whether it was the same
+ *              once moved back, which is cleared if it was not
+ * @returns: the mean time of a move in nanoseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double timeMoves(CollabGraph &graph, const string &expected,
+                        bool &same) {
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < REPEATS; i++) {
+        CollabGraph moved(move(graph));
+        graph = move(moved);
+    }
+    double moveNs = milliseconds(start) * 1e6 / (2 * REPEATS);
+
+    same = same and printed(graph) == expected;
+    return moveNs;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: timeSharedCopies
+ * @purpose: copies a frozen graph many times
+ *
+ * @parameters: the graph
+ * @returns: the mean time of a copy in nanoseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double timeSharedCopies(const CollabGraph &graph) {
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < REPEATS; i++) {
+        CollabGraph copy(graph);
+    }
+    return milliseconds(start) * 1e6 / REPEATS;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 or argc > 3) {
+        cerr << "Usage: CopyBench dataFile [updates]\n";
+        return EXIT_FAILURE;
+    }
+    size_t numUpdates = argc > 2 ? atol(argv[2]) : 1000;
+
+    SixDegrees program(2, argv);
+    CollabGraph &frozen = program.load();
+    size_t numArtists = frozen.vertex_count();
+    if (numArtists == 0) {
+        cerr << argv[1] << " has no artists.\n";
+        return EXIT_FAILURE;
+    }
+
+    // The same graph, built the old way, one artist and edge at a time
+    Clock::time_point start = Clock::now();
+    CollabGraph unfrozen;
+    for (CollabGraph::VertexId v = 0; v < numArtists; v++) {
+        unfrozen.insert_vertex(Artist(string(frozen.get_vertex_name(v))));
+    }
+    for (CollabGraph::VertexId v = 0; v < numArtists; v++) {
+        const CollabGraph::VertexId *neighbor = frozen.neighbors_begin(v);
+        for (; neighbor < frozen.neighbors_end(v); neighbor++) {
+            if (*neighbor < v) {
+                continue;
+            }
+            unfrozen.insert_edge(
+                Artist(string(frozen.get_vertex_name(v))),
+                Artist(string(frozen.get_vertex_name(*neighbor))),
+                frozen.get_edge(v, *neighbor));
+        }
+    }
+    double insertMs = milliseconds(start);
+
+    bool same = true;
+    string expected = printed(frozen);
+    same = same and printed(unfrozen) == expected;
+
+    double unfrozenCopyMs = timeCopy(unfrozen, expected, same);
+    double unfrozenMoveNs = timeMoves(unfrozen, expected, same);
+    double frozenCopyMs   = timeCopy(frozen, expected, same);
+    double frozenCopyNs   = timeSharedCopies(frozen);
+    double frozenMoveNs   = timeMoves(frozen, expected, same);
+
+    // A copy given new songs and artists leaves the original as it was,
+    // and can itself be copied
+    CollabGraph updated(frozen);
+    for (size_t i = 0; i < numUpdates; i++) {
+        string name = "Added Artist " + to_string(i);
+        string song = "Added Song " + to_string(i / 2);
+        updated.add_artist(name, {song});
+        updated.add_song(frozen.get_vertex_name(i * 7919 % numArtists),
+                         song);
+    }
+    same = same and printed(frozen) == expected;
+
+    string updatedExpected = printed(updated);
+    double updatedCopyMs   = timeCopy(updated, updatedExpected, same);
+
+    // A copy's added names and songs are its own, so it outlives the
+    // original
+    CollabGraph survivor(updated);
+    updated = CollabGraph();
+    same = same and printed(survivor) == updatedExpected;
+
+    cout << "graph: " << numArtists << " artists, "
+         << frozen.adjacency_size() / 2 << " collaborations, "
+         << frozen.memory_footprint() << " bytes frozen, "
+         << unfrozen.memory_footprint() << " bytes unfrozen\n"
+         << "unfrozen insertion:      " << insertMs << " ms\n"
+         << "unfrozen copy:           " << unfrozenCopyMs << " ms\n"
+         << "unfrozen move:           " << unfrozenMoveNs << " ns\n"
+         << "frozen copy:             " << frozenCopyMs << " ms ("
+         << frozenCopyNs << " ns when repeated)\n"
+         << "frozen move:             " << frozenMoveNs << " ns\n"
+         << "copy after updates:      " << updatedCopyMs << " ms ("
+         << numUpdates << " artists and songs added)\n"
+         << "copies the same:         " << (same ? "yes" : "no") << "\n";
+
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
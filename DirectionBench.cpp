@@ -0,0 +1,150 @@
+/*
+ * DirectionBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Compares the classic queue-based bfs with the direction-optimizing one
+ * on a synthetic power-law graph. The graph grows by preferential
+ * attachment: each new artist collaborates with a few earlier artists,
+ * picked with probability proportional to how many collaborations they
+ * already have, which gives a few hubs with huge degrees and one giant
+ * component, like real collaboration graphs. The same random bfs queries
+ * are answered by both engines, and the lengths of their paths compared.
+ *
+ * Usage: DirectionBench [artists] [collaborations per artist] [queries]
+ *
+ */
+
+#include "Artist.h"
+#include "CollabGraph.h"
+#include "TraversalEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: answer
+ * @purpose: answers every query with one engine, timing them all
+ *
+ * @parameters: the engine, the queries, and where to store each query's
+ *              output
+ * @returns: the time taken in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double answer(TraversalEngine &engine, const vector<Query> &queries,
+                     vector<string> &outputs) {
+    ostringstream output;
+    double total = 0;
+
+    for (size_t q = 0; q < queries.size(); q++) {
+        output.str("");
+        Clock::time_point start = Clock::now();
+        engine.run(queries[q], output);
+        total += milliseconds(start);
+        outputs[q] = output.str();
+    }
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    size_t numArtists = argc > 1 ? atol(argv[1]) : 300000;
+    size_t perArtist  = argc > 2 ? atol(argv[2]) : 8;
+    size_t numQueries = argc > 3 ? atol(argv[3]) : 200;
+
+    if (numArtists <= perArtist or perArtist < 1 or numQueries < 1) {
+        cerr << "Usage: DirectionBench [artists] [collaborations per artist]"
+             << " [queries]\n";
+        return EXIT_FAILURE;
+    }
+
+    mt19937 random(15);
+    vector<Artist> artists;
+    for (size_t i = 0; i < numArtists; i++) {
+        artists.push_back(Artist("Artist " + to_string(i)));
+    }
+
+    CollabGraph graph;
+    for (size_t i = 0; i < numArtists; i++) {
+        graph.insert_vertex(artists[i]);
+    }
+
+    // Every collaboration adds both artists to ends, so picking from it
+    // picks artists in proportion to their degree
+    vector<size_t> ends;
+    for (size_t i = 1; i <= perArtist; i++) {
+        graph.insert_edge(artists[0], artists[i], "Song 0." + to_string(i));
+        ends.push_back(0);
+        ends.push_back(i);
+    }
+    for (size_t i = perArtist + 1; i < numArtists; i++) {
+        for (size_t e = 0; e < perArtist; e++) {
+            size_t j = ends[random() % ends.size()];
+            if (j != i) {
+                graph.insert_edge(artists[i], artists[j],
+                                  "Song " + to_string(i) + "." +
+                                      to_string(e));
+                ends.push_back(i);
+                ends.push_back(j);
+            }
+        }
+    }
+    graph.freeze();
+
+    vector<Query> queries(numQueries);
+    for (size_t q = 0; q < numQueries; q++) {
+        queries[q].command = "bfs";
+        queries[q].source  = artists[random() % numArtists].get_name();
+        queries[q].dest    = artists[random() % numArtists].get_name();
+    }
+
+    TraversalEngine classic(graph), optimizing(graph);
+    optimizing.setDirectionOptimizing(true);
+
+    vector<string> classicOutputs(numQueries), optimizingOutputs(numQueries);
+    double classicMs = answer(classic, queries, classicOutputs);
+    double optimizingMs = answer(optimizing, queries, optimizingOutputs);
+
+    // A path prints one line per collaboration, so equal lengths mean
+    // equally many lines
+    size_t sameLength = 0, samePath = 0;
+    for (size_t q = 0; q < numQueries; q++) {
+        sameLength += count(classicOutputs[q].begin(),
+                            classicOutputs[q].end(), '\n') ==
+                      count(optimizingOutputs[q].begin(),
+                            optimizingOutputs[q].end(), '\n');
+        samePath += classicOutputs[q] == optimizingOutputs[q];
+    }
+
+    cout << "graph: " << numArtists << " artists, about " << ends.size() / 2
+         << " collaborations, " << numQueries << " bfs queries\n"
+         << "classic bfs:              " << classicMs / numQueries
+         << " ms/query\n"
+         << "direction-optimizing bfs: " << optimizingMs / numQueries
+         << " ms/query\n"
+         << "same path lengths:        " << sameLength << " of "
+         << numQueries << " (" << samePath << " identical paths)\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/*
+ * EdgeBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures edge lookups on hub artists. A few hubs each collaborate with
+ * every one of a large pool of artists, and the edges are inserted in a
+ * random order. It times:
+ *   1) inserting every edge, each of which first checks for a duplicate
+ *   2) inserting every edge again, which only finds the duplicates
+ *   3) get_edge between a hub and a random collaborator, before and after
+ *      the graph is frozen
+ *
+ * Usage: EdgeBench [hubs] [collaborators] [lookups]
+ *
+ */
+
+#include "Artist.h"
+#include "CollabGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t numHubs    = argc > 1 ? atol(argv[1]) : 2;
+    size_t numCollabs = argc > 2 ? atol(argv[2]) : 100000;
+    size_t numLookups = argc > 3 ? atol(argv[3]) : 1000000;
+
+    if (numHubs < 1 or numCollabs < 1 or numLookups < 1) {
+        cerr << "Usage: EdgeBench [hubs] [collaborators] [lookups]\n";
+        return EXIT_FAILURE;
+    }
+
+    mt19937 random(15);
+    vector<Artist> hubs, collabs;
+    for (size_t h = 0; h < numHubs; h++) {
+        hubs.push_back(Artist("Hub " + to_string(h)));
+    }
+    for (size_t c = 0; c < numCollabs; c++) {
+        collabs.push_back(Artist("Artist " + to_string(c)));
+    }
+
+    CollabGraph graph;
+    for (const Artist &hub : hubs) graph.insert_vertex(hub);
+    for (const Artist &collab : collabs) graph.insert_vertex(collab);
+
+    vector<pair<size_t, size_t>> edges;
+    for (size_t h = 0; h < numHubs; h++) {
+        for (size_t c = 0; c < numCollabs; c++) edges.push_back({h, c});
+    }
+    shuffle(edges.begin(), edges.end(), random);
+
+    // 1) Every insertion checks the hub's edges for a duplicate
+    Clock::time_point start = Clock::now();
+    for (const pair<size_t, size_t> &edge : edges) {
+        graph.insert_edge(hubs[edge.first], collabs[edge.second],
+                          "Song " + to_string(edge.second));
+    }
+    double insertMs = milliseconds(start);
+
+    // 2) Every insertion is a duplicate
+    start = Clock::now();
+    for (const pair<size_t, size_t> &edge : edges) {
+        graph.insert_edge(hubs[edge.first], collabs[edge.second],
+                          "Again " + to_string(edge.second));
+    }
+    double duplicateMs = milliseconds(start);
+
+    // 3) Lookups between a hub and a random collaborator
+    vector<pair<size_t, size_t>> lookups(numLookups);
+    for (pair<size_t, size_t> &lookup : lookups) {
+        lookup = {random() % numHubs, random() % numCollabs};
+    }
+
+    size_t found = 0;
+    start = Clock::now();
+    for (const pair<size_t, size_t> &lookup : lookups) {
+        found += graph.get_edge(hubs[lookup.first], collabs[lookup.second])
+                     .size();
+    }
+    double lookupNs = milliseconds(start) * 1e6 / numLookups;
+
+    graph.freeze();
+
+    string song;
+    start = Clock::now();
+    for (const pair<size_t, size_t> &lookup : lookups) {
+        graph.get_edge(lookup.first, numHubs + lookup.second, song);
+        found -= song.size();
+    }
+    double frozenNs = milliseconds(start) * 1e6 / numLookups;
+
+    cout << "graph: " << numHubs << " hubs with " << numCollabs
+         << " collaborators each\n"
+         << "insert edges:         " << insertMs << " ms\n"
+         << "insert duplicates:    " << duplicateMs << " ms\n"
+         << "get_edge (unfrozen):  " << lookupNs << " ns\n"
+         << "get_edge (frozen):    " << frozenNs << " ns\n"
+         << "same edges:           " << (found == 0 ? "yes" : "no") << "\n";
+
+    return EXIT_SUCCESS;
+}
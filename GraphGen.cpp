@@ -0,0 +1,106 @@
+/*
+ * GraphGen.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Writes a synthetic data file, in the format SixDegrees reads, to
+ * standard output. Every artist writes the given number of songs, and each
+ * song is also listed by one collaborator, so each song is one edge (or
+ * none, when two artists happen to share more than one). The shape decides
+ * who the collaborator is:
+ *   er         anyone, uniformly (an Erdos-Renyi graph)
+ *   power-law  an earlier artist, picked in proportion to how many
+ *              collaborations it has so far (preferential attachment)
+ *   hub        one of four hub artists for a quarter of the songs, and
+ *              anyone, uniformly, for the rest
+ * The same arguments always write the same file.
+ *
+ * Usage: GraphGen er|power-law|hub artists songsPerArtist [seed]
+ *
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A song, named by the artist that wrote it and which of its songs it is
+struct Song {
+    uint32_t writer;
+    uint32_t number;
+};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: pickPartner
+ * @purpose: chooses who an artist's next song is a collaboration with
+ *
+ * @parameters: the shape, the writer, the number of artists, the random
+ *              generator, and every collaboration's two artists so far
+ * @returns: the collaborator, which may be the writer itself when the song
+ *           is a solo
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static uint32_t pickPartner(const string &shape, uint32_t writer,
+                            uint32_t numArtists, mt19937 &random,
+                            const vector<uint32_t> &ends) {
+    const uint32_t HUBS = 4;
+
+    if (shape == "power-law" and ends.empty()) {
+        return writer == 0 ? writer : random() % writer;
+    }
+    if (shape == "power-law") {
+        return ends[random() % ends.size()];
+    }
+    if (shape == "hub" and random() % 4 == 0) {
+        return random() % HUBS;
+    }
+    return random() % numArtists;
+}
+
+int main(int argc, char *argv[]) {
+    string shape = argc > 1 ? argv[1] : "";
+    uint32_t numArtists = argc > 2 ? atol(argv[2]) : 0;
+    uint32_t perArtist  = argc > 3 ? atol(argv[3]) : 0;
+    uint32_t seed       = argc > 4 ? atol(argv[4]) : 15;
+
+    if (argc < 4 or argc > 5 or numArtists < 2 or perArtist < 1 or
+        (shape != "er" and shape != "power-law" and shape != "hub")) {
+        cerr << "Usage: GraphGen er|power-law|hub artists songsPerArtist"
+             << " [seed]\n";
+        return EXIT_FAILURE;
+    }
+
+    // Every collaboration adds both artists to ends, so picking from it
+    // picks artists in proportion to their collaborations
+    mt19937 random(seed);
+    vector<vector<Song>> lists(numArtists);
+    vector<uint32_t> ends;
+    for (uint32_t a = 0; a < numArtists; a++) {
+        for (uint32_t s = 0; s < perArtist; s++) {
+            uint32_t partner = pickPartner(shape, a, numArtists, random,
+                                           ends);
+            lists[a].push_back(Song{a, s});
+            if (partner != a) {
+                lists[partner].push_back(Song{a, s});
+                ends.push_back(a);
+                ends.push_back(partner);
+            }
+        }
+    }
+
+    ios::sync_with_stdio(false);
+    for (uint32_t a = 0; a < numArtists; a++) {
+        cout << "Artist " << a << "\n";
+        for (const Song &song : lists[a]) {
+            cout << "Song " << song.writer << "." << song.number << "\n";
+        }
+        cout << "*\n";
+    }
+
+    return EXIT_SUCCESS;
+}
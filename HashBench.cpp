@@ -0,0 +1,215 @@
+/*
+ * HashBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures what a query pays for looking artists up by name. The same bfs
+ * queries are answered twice on the same random graph:
+ *   1) the way SixDegrees used to, through the Artist interface of an
+ *      unfrozen CollabGraph, where every step looks a name up in the
+ *      string-keyed map
+ *   2) by a TraversalEngine on the frozen graph, which translates the two
+ *      names into ids once and then only works on ids
+ * It also times a single lookup in each kind of name dictionary.
+ *
+ * Usage: HashBench [artists] [degree] [queries]
+ *
+ */
+
+#include "Artist.h"
+#include "CollabGraph.h"
+#include "TraversalEngine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Name lookups made by the string-keyed queries
+static size_t lookups = 0;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: stringBfs
+ * @purpose: answers a bfs query the way SixDegrees did before the graph
+ *           had ids, counting the name lookups it makes
+ *
+ * @preconditions: graph is not frozen
+ * @postconditions: the path, if any, is printed to output
+ *
+ * @parameters: the graph, both artists, and where to print output
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void stringBfs(CollabGraph &graph, const Artist &a1,
+                      const Artist &a2, ostream &output) {
+    graph.clear_metadata();
+
+    lookups += 4;
+    if (not graph.is_vertex(a1) or not graph.is_vertex(a2) or
+        graph.is_marked(a1) or graph.is_marked(a2)) {
+        return;
+    }
+
+    queue<Artist> pQueue;
+    graph.mark_vertex(a1);
+    lookups++;
+    pQueue.push(a1);
+
+    while (not pQueue.empty()) {
+        Artist next = pQueue.front();
+        graph.mark_vertex(next);
+        lookups++;
+
+        if (next == a2) {
+            break;
+        }
+
+        vector<Artist> neighbors = graph.get_vertex_neighbors(next);
+        lookups++;
+        for (size_t i = 0; i < neighbors.size(); i++) {
+            lookups++;
+            if (not graph.is_marked(neighbors.at(i))) {
+                graph.mark_vertex(neighbors.at(i));
+                graph.set_predecessor(neighbors.at(i), next);
+                lookups += 3;
+                pQueue.push(neighbors.at(i));
+            }
+        }
+        pQueue.pop();
+    }
+
+    // Print the path the way printPath does, one edge lookup per step
+    stack<Artist> path = graph.report_path(a1, a2);
+    lookups += 2;
+    if (path.empty()) {
+        output << "A path does not exist between \"" << a1 << "\" and \""
+               << a2 << "\".\n";
+        return;
+    }
+    while (path.size() > 1) {
+        Artist from = path.top();
+        path.pop();
+        output << '"' << from << "\" collaborated with \"" << path.top()
+               << "\" in \"" << graph.get_edge(from, path.top()) << "\".\n";
+        lookups += 2;
+    }
+    output << "***\n";
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nanoseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in nanoseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double nanoseconds(Clock::time_point start) {
+    return chrono::duration<double, nano>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t numArtists = argc > 1 ? atol(argv[1]) : 100000;
+    size_t degree     = argc > 2 ? atol(argv[2]) : 10;
+    size_t numQueries = argc > 3 ? atol(argv[3]) : 200;
+
+    if (numArtists < 2 or numQueries < 1) {
+        cerr << "Usage: HashBench [artists] [degree] [queries]\n";
+        return EXIT_FAILURE;
+    }
+
+    // Build the same random graph twice, once to freeze
+    mt19937 random(15);
+    vector<Artist> artists;
+    for (size_t i = 0; i < numArtists; i++) {
+        artists.push_back(Artist("Artist " + to_string(i)));
+    }
+
+    CollabGraph byName, byId;
+    for (size_t i = 0; i < numArtists; i++) {
+        byName.insert_vertex(artists[i]);
+        byId.insert_vertex(artists[i]);
+    }
+    for (size_t i = 0; i < numArtists; i++) {
+        for (size_t e = 0; e < degree / 2; e++) {
+            size_t j = random() % numArtists;
+            if (j != i) {
+                string song = "Song " + to_string(random() % 1000000);
+                byName.insert_edge(artists[i], artists[j], song);
+                byId.insert_edge(artists[i], artists[j], song);
+            }
+        }
+    }
+    byId.freeze();
+
+    vector<Query> queries(numQueries);
+    for (size_t q = 0; q < numQueries; q++) {
+        queries[q].command = "bfs";
+        queries[q].source  = artists[random() % numArtists].get_name();
+        queries[q].dest    = artists[random() % numArtists].get_name();
+    }
+
+    // 1) Every step looks names up in the string-keyed map
+    ostringstream byNameOutput;
+    Clock::time_point start = Clock::now();
+    for (const Query &query : queries) {
+        stringBfs(byName, Artist(query.source), Artist(query.dest),
+                  byNameOutput);
+    }
+    double byNameNs = nanoseconds(start) / numQueries;
+    double byNameLookups = (double) lookups / numQueries;
+
+    // 2) The names are translated into ids once per query
+    ostringstream byIdOutput;
+    TraversalEngine engine(byId);
+    start = Clock::now();
+    for (const Query &query : queries) {
+        engine.run(query, byIdOutput);
+    }
+    double byIdNs = nanoseconds(start) / numQueries;
+
+    // A single lookup in each kind of dictionary
+    unordered_map<string, size_t> names;
+    for (size_t i = 0; i < numArtists; i++) {
+        names.insert({artists[i].get_name(), i});
+    }
+
+    const size_t LOOKUPS = 1000000;
+    size_t found = 0;
+    start = Clock::now();
+    for (size_t l = 0; l < LOOKUPS; l++) {
+        found += names.count(queries[l % numQueries].source);
+    }
+    double mapNs = nanoseconds(start) / LOOKUPS;
+
+    start = Clock::now();
+    for (size_t l = 0; l < LOOKUPS; l++) {
+        found += byId.get_vertex_id(queries[l % numQueries].source) !=
+                 CollabGraph::NO_VERTEX;
+    }
+    double idNs = nanoseconds(start) / LOOKUPS;
+
+    cout << "graph: " << numArtists << " artists, about "
+         << numArtists * (degree / 2) << " collaborations, " << numQueries
+         << " bfs queries\n"
+         << "string-keyed bfs: " << byNameNs / 1000 << " us/query, "
+         << byNameLookups << " name lookups/query\n"
+         << "id-keyed bfs:     " << byIdNs / 1000 << " us/query, "
+         << "2 name lookups/query\n"
+         << "one name lookup:  unordered_map<string> " << mapNs
+         << " ns, get_vertex_id " << idNs << " ns\n"
+         << "same paths:       "
+         << (byNameOutput.str() == byIdOutput.str() ? "yes" : "no")
+         << " (" << found / 2 << " lookups hit)\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/*
+ * InclBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures what the two-layer search behind incl saves over the obvious
+ * way of answering it with bfs. On one data file, such as one written by
+ * GraphGen, random incl queries are answered twice:
+ *   1) with one incl query each
+ *   2) with bfs queries: from the source to the artist to pass through and
+ *      from that artist to the destination, or, for a song, from the
+ *      source to each of the song's artists and from each of them to the
+ *      destination, keeping the shortest combination
+ * Half of the queries pass through an artist and half through a song, and
+ * the lengths of the paths found both ways are compared.
+ *
+ * Usage: InclBench dataFile [queries] [seed]
+ *
+ */
+
+#include "CollabGraph.h"
+#include "SixDegrees.h"
+#include "TraversalEngine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Length of a path that does not exist
+static const size_t NO_PATH = SIZE_MAX;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: pathLength
+ * @purpose: answers a bfs or incl query, and counts the collaborations on
+ *           the path it prints
+ *
+ * @parameters: the engine, the query, and a stream to print to
+ * @returns: the number of collaborations on the path, 0 if the query's
+ *           Artists are the same one, or NO_PATH if there is no path
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static size_t pathLength(TraversalEngine &engine, const Query &query,
+                         ostringstream &output) {
+    if (query.command == "bfs" and query.source == query.dest) {
+        return 0;
+    }
+
+    output.str("");
+    engine.run(query, output);
+
+    size_t lines = 0;
+    for (char c : output.str()) {
+        lines += (c == '\n');
+    }
+    return output.str().find("***\n") == string::npos ? NO_PATH : lines - 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 or argc > 4) {
+        cerr << "Usage: InclBench dataFile [queries] [seed]\n";
+        return EXIT_FAILURE;
+    }
+    size_t numQueries = argc > 2 ? atol(argv[2]) : 200;
+    unsigned seed     = argc > 3 ? atol(argv[3]) : 15;
+
+    SixDegrees program(2, argv);
+    CollabGraph &graph = program.load();
+
+    size_t numArtists = graph.vertex_count();
+    if (numArtists == 0 or graph.adjacency_size() == 0 or numQueries == 0) {
+        cerr << argv[1] << " has no collaborations to query.\n";
+        return EXIT_FAILURE;
+    }
+
+    // Every other query passes through a song, named by a random edge
+    mt19937_64 random(seed);
+    vector<Query> queries(numQueries);
+    for (size_t i = 0; i < numQueries; i++) {
+        Query &query = queries[i];
+        query.command = "incl";
+        query.source  = string(graph.get_vertex_name(random() % numArtists));
+        query.dest    = string(graph.get_vertex_name(random() % numArtists));
+
+        CollabGraph::VertexId through = random() % numArtists;
+        if (i % 2 == 0) {
+            query.through = string(graph.get_vertex_name(through));
+            continue;
+        }
+        while (graph.neighbors_begin(through) == 
+               graph.neighbors_end(through)) {
+            through = random() % numArtists;
+        }
+        graph.get_edge(through, *graph.neighbors_begin(through),
+                       query.through);
+    }
+
+    TraversalEngine engine(graph);
+    ostringstream output;
+
+    vector<size_t> inclLengths;
+    Clock::time_point start = Clock::now();
+    for (const Query &query : queries) {
+        inclLengths.push_back(pathLength(engine, query, output));
+    }
+    double inclMs = milliseconds(start);
+
+    // The same paths, from bfs queries to and from whatever is passed
+    // through
+    Query leg;
+    leg.command = "bfs";
+    vector<CollabGraph::VertexId> artists;
+    vector<size_t> bfsLengths;
+    size_t bfsQueries = 0;
+    start = Clock::now();
+    for (const Query &query : queries) {
+        CollabGraph::VertexId through = graph.get_vertex_id(query.through);
+        bool bySong = (through == CollabGraph::NO_VERTEX);
+        if (bySong) {
+            graph.get_song_artists(query.through, artists);
+        }
+        else {
+            artists.assign(1, through);
+        }
+
+        vector<size_t> toArtist, fromArtist;
+        for (CollabGraph::VertexId artist : artists) {
+            leg.source = query.source;
+            leg.dest   = string(graph.get_vertex_name(artist));
+            toArtist.push_back(pathLength(engine, leg, output));
+            leg.source = leg.dest;
+            leg.dest   = query.dest;
+            fromArtist.push_back(pathLength(engine, leg, output));
+            bfsQueries += 2;
+        }
+
+        // An artist is passed through on its own, and a song between two
+        // different artists
+        size_t best = NO_PATH;
+        for (size_t u = 0; u < artists.size(); u++) {
+            for (size_t v = 0; v < artists.size(); v++) {
+                if ((bySong and u == v) or (not bySong and u != v) or
+                    toArtist[u] == NO_PATH or fromArtist[v] == NO_PATH) {
+                    continue;
+                }
+                best = min(best, toArtist[u] + fromArtist[v] + bySong);
+            }
+        }
+        bfsLengths.push_back(query.source == query.dest ? NO_PATH : best);
+    }
+    double bfsMs = milliseconds(start);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < numQueries; i++) {
+        mismatches += (inclLengths[i] != bfsLengths[i]);
+    }
+
+    cout << "graph: " << numArtists << " artists, "
+         << graph.adjacency_size() / 2 << " collaborations, " << numQueries
+         << " queries\n"
+         << "incl:            " << inclMs << " ms\n"
+         << "bfs to and from: " << bfsMs << " ms (" << bfsQueries
+         << " bfs queries)\n"
+         << "same lengths:    " << (mismatches == 0 ? "yes" : "no") << "\n";
+
+    return EXIT_SUCCESS;
+}
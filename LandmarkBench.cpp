@@ -0,0 +1,154 @@
+/*
+ * LandmarkBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures the landmark distance oracle on one data file, such as the
+ * power-law files GraphGen writes. For several numbers of landmarks it
+ * times:
+ *   1) building the landmark distances, and the memory they take
+ *   2) bounding a distance, which is all a degrees query does, and how
+ *      often the upper bound, or both bounds, are the exact distance
+ *   3) the same bfs queries with and without the landmarks guiding them,
+ *      whose outputs should be identical
+ *
+ * Usage: LandmarkBench dataFile [queries] [seed]
+ *
+ */
+
+#include "CollabGraph.h"
+#include "SixDegrees.h"
+#include "TraversalEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: answer
+ * @purpose: answers every query with one engine, timing them all
+ *
+ * @parameters: the engine, the queries, and where to print their output
+ * @returns: the time taken in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double answer(TraversalEngine &engine, const vector<Query> &queries,
+                     ostream &output) {
+    Clock::time_point start = Clock::now();
+    for (const Query &query : queries) {
+        engine.run(query, output);
+    }
+    return milliseconds(start);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 or argc > 4) {
+        cerr << "Usage: LandmarkBench dataFile [queries] [seed]\n";
+        return EXIT_FAILURE;
+    }
+    size_t numQueries = argc > 2 ? atol(argv[2]) : 200;
+    unsigned seed     = argc > 3 ? atol(argv[3]) : 15;
+
+    SixDegrees program(2, argv);
+    CollabGraph &graph = program.load();
+
+    size_t numArtists = graph.vertex_count();
+    if (numArtists < 1 or numQueries == 0) {
+        cerr << argv[1] << " does not have an artist to query.\n";
+        return EXIT_FAILURE;
+    }
+
+    // The queries are first answered without landmarks
+    if (graph.landmark_count() > 0) {
+        cerr << argv[1] << " has landmarks; give the data file instead.\n";
+        return EXIT_FAILURE;
+    }
+
+    mt19937_64 random(seed);
+    vector<Query> queries(numQueries);
+    for (Query &query : queries) {
+        query.command = "bfs";
+        query.source  = string(graph.get_vertex_name(random() % numArtists));
+        query.dest    = string(graph.get_vertex_name(random() % numArtists));
+    }
+
+    // The true distances, from the unguided bfs: one line per hop
+    TraversalEngine engine(graph);
+    vector<size_t> hops(numQueries);
+    ostringstream plainOutput, output;
+    for (size_t q = 0; q < numQueries; q++) {
+        output.str("");
+        engine.run(queries[q], output);
+        string path = output.str();
+        hops[q] = count(path.begin(), path.end(), '\n') - 1;
+        plainOutput << path;
+    }
+    double plainMs = answer(engine, queries, output);
+
+    cout << "graph: " << numArtists << " artists, "
+         << graph.adjacency_size() / 2 << " collaborations, " << numQueries
+         << " queries\n"
+         << "bfs without landmarks: " << plainMs / numQueries
+         << " ms/query\n";
+
+    const size_t COUNTS[] = {4, 16, 64};
+    for (size_t count : COUNTS) {
+        size_t before = graph.memory_footprint();
+        Clock::time_point start = Clock::now();
+        graph.build_landmarks(count, 1);
+        double buildMs = milliseconds(start);
+        double megabytes = (graph.memory_footprint() - before) / 1e6;
+
+        // Bound every pair many times over, since one takes so little time
+        const size_t REPEATS = 1000;
+        size_t exact = 0, tight = 0;
+        uint32_t lower, upper;
+        start = Clock::now();
+        for (size_t r = 0; r < REPEATS; r++) {
+            for (size_t q = 0; q < numQueries; q++) {
+                graph.distance_bounds(graph.get_vertex_id(queries[q].source),
+                                      graph.get_vertex_id(queries[q].dest),
+                                      lower, upper);
+                tight += r == 0 and upper == hops[q];
+                exact += r == 0 and upper == hops[q] and lower == hops[q];
+            }
+        }
+        double degreesNs = milliseconds(start) * 1e6 / REPEATS / numQueries;
+
+        ostringstream guidedOutput;
+        double guidedMs = answer(engine, queries, guidedOutput);
+
+        cout << count << " landmarks: built in " << buildMs << " ms, "
+             << megabytes << " MB\n"
+             << "    bounds:     " << degreesNs << " ns, upper bound exact "
+             << tight << " of " << numQueries << " times, both " << exact
+             << "\n"
+             << "    guided bfs: " << guidedMs / numQueries
+             << " ms/query, same output: "
+             << (guidedOutput.str() == plainOutput.str() ? "yes" : "no")
+             << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/*
+ * ManyBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures what bfs-many saves over asking the same questions one at a
+ * time. On a random frozen graph, paths from one source to many targets
+ * are found twice:
+ *   1) with one bfs query per target
+ *   2) with a single bfs-many query listing every target
+ * and the two outputs are compared.
+ *
+ * Usage: ManyBench [artists] [degree] [targets]
+ *
+ */
+
+#include "Artist.h"
+#include "CollabGraph.h"
+#include "TraversalEngine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t numArtists = argc > 1 ? atol(argv[1]) : 100000;
+    size_t degree     = argc > 2 ? atol(argv[2]) : 10;
+    size_t numTargets = argc > 3 ? atol(argv[3]) : 1000;
+
+    if (numArtists < 2 or numTargets < 1) {
+        cerr << "Usage: ManyBench [artists] [degree] [targets]\n";
+        return EXIT_FAILURE;
+    }
+
+    // A random graph, built the way HashBench builds it
+    mt19937 random(15);
+    vector<Artist> artists;
+    for (size_t i = 0; i < numArtists; i++) {
+        artists.push_back(Artist("Artist " + to_string(i)));
+    }
+
+    CollabGraph graph;
+    for (size_t i = 0; i < numArtists; i++) {
+        graph.insert_vertex(artists[i]);
+    }
+    for (size_t i = 0; i < numArtists; i++) {
+        for (size_t e = 0; e < degree / 2; e++) {
+            size_t j = random() % numArtists;
+            if (j != i) {
+                graph.insert_edge(artists[i], artists[j],
+                                  "Song " + to_string(random() % 1000000));
+            }
+        }
+    }
+    graph.freeze();
+
+    Query many;
+    many.command = "bfs-many";
+    many.source  = artists[random() % numArtists].get_name();
+    for (size_t t = 0; t < numTargets; t++) {
+        many.targets.push_back(artists[random() % numArtists].get_name());
+    }
+    many.numTargets = numTargets;
+
+    TraversalEngine engine(graph);
+
+    // 1) One bfs per target
+    ostringstream oneByOne;
+    Query query;
+    query.command = "bfs";
+    query.source  = many.source;
+    Clock::time_point start = Clock::now();
+    for (size_t t = 0; t < numTargets; t++) {
+        query.dest = many.targets[t];
+        engine.run(query, oneByOne);
+    }
+    double oneByOneMs = milliseconds(start);
+
+    // 2) One bfs-many for all of them
+    ostringstream together;
+    start = Clock::now();
+    engine.run(many, together);
+    double togetherMs = milliseconds(start);
+
+    cout << "graph: " << numArtists << " artists, about "
+         << numArtists * (degree / 2) << " collaborations, " << numTargets
+         << " targets\n"
+         << "bfs one by one: " << oneByOneMs << " ms\n"
+         << "bfs-many:       " << togetherMs << " ms\n"
+         << "same output:    "
+         << (oneByOne.str() == together.str() ? "yes" : "no") << "\n";
+
+    return EXIT_SUCCESS;
+}
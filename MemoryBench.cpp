@@ -0,0 +1,101 @@
+/*
+ * MemoryBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures how much memory each layout of the graph takes. A random graph
+ * is built with insert_vertex and insert_edge, the way a graph is built
+ * before it is frozen, and its memory_footprint is printed; the graph is
+ * then frozen into the compressed sparse row layout, and printed again.
+ * Every collaboration is between two artists picked uniformly, and is
+ * named by its own song.
+ *
+ * Usage: MemoryBench [artists] [collaborations]
+ *
+ */
+
+#include "Artist.h"
+#include "CollabGraph.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: megabytes
+ * @purpose: converts a number of bytes to megabytes
+ *
+ * @parameters: the number of bytes
+ * @returns: the same amount in megabytes
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double megabytes(size_t bytes) {
+    return bytes / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    size_t numArtists = argc > 1 ? atol(argv[1]) : 500000;
+    size_t numCollabs = argc > 2 ? atol(argv[2]) : 3000000;
+
+    if (argc > 3 or numArtists < 2) {
+        cerr << "Usage: MemoryBench [artists] [collaborations]\n";
+        return EXIT_FAILURE;
+    }
+
+    mt19937 random(15);
+    vector<Artist> artists;
+    for (size_t i = 0; i < numArtists; i++) {
+        artists.push_back(Artist("Artist " + to_string(i)));
+    }
+
+    Clock::time_point start = Clock::now();
+    CollabGraph graph;
+    for (const Artist &artist : artists) {
+        graph.insert_vertex(artist);
+    }
+
+    // Loops are not collaborations, and a pair picked twice keeps the
+    // song it was given first
+    for (size_t c = 0; c < numCollabs; c++) {
+        size_t i = random() % numArtists;
+        size_t j = random() % numArtists;
+        if (i != j) {
+            graph.insert_edge(artists[i], artists[j], "Song " + to_string(c));
+        }
+    }
+    double buildMs = milliseconds(start);
+    size_t unfrozenBytes = graph.memory_footprint();
+
+    start = Clock::now();
+    graph.freeze();
+    double freezeMs = milliseconds(start);
+    size_t frozenBytes = graph.memory_footprint();
+
+    cout << "graph: " << numArtists << " artists, "
+         << graph.adjacency_size() / 2 << " collaborations\n"
+         << "unfrozen: " << megabytes(unfrozenBytes) << " MB (built in "
+         << buildMs << " ms)\n"
+         << "frozen:   " << megabytes(frozenBytes) << " MB (frozen in "
+         << freezeMs << " ms)\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,445 @@
+/*
+ * ResultWriter.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Implementation for the ResultWriter interface. Every result is appended
+ * to one string that keeps its capacity, and a writer with a stream only
+ * writes to it once FLUSH_SIZE bytes have built up (or when told to), so
+ * the stream sees a few large writes instead of one per piece of text.
+ *
+ * The formats, result by result:
+ *   text  the lines SixDegrees has always printed
+ *   tsv   "step" from-id from to-id to song, one row per collaboration,
+ *         then "end"; "no_path" source dest; "not_found" name;
+ *         "degrees" source dest lower upper (empty if unknown);
+ *         "message" text. Tabs, newlines and backslashes in fields are
+ *         escaped as \t, \n and \\
+ *   json  {"path": [{"from": id, "from_name": ..., "to": id,
+ *         "to_name": ..., "song": ...}, ...]}, {"no_path": {"source": ...,
+ *         "dest": ...}}, {"not_found": ...}, {"degrees": {"source": ...,
+ *         "dest": ..., "lower": n, "upper": n or null}}, {"message": ...},
+ *         one per line
+ *
+ */
+
+#include "ResultWriter.h"
+
+#include <charconv>
+
+using namespace std;
+
+// How much output a writer with a stream keeps before writing it
+static const size_t FLUSH_SIZE = 1 << 16;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructors
+ * @purpose: initialize a ResultWriter
+ *
+ * @preconditions: the stream, if given, outlives the writer
+ * @postconditions: the writer is empty, and writes in the given format;
+ *                  nothing reaches the stream until the writer is flushed
+ *
+ * @parameters: the format, and the stream to pass output on to, if any
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+ResultWriter::ResultWriter(Format format) : format(format), sink(nullptr) {
+
+}
+
+ResultWriter::ResultWriter(Format format, ostream &sink)
+    : format(format), sink(&sink) {
+
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: parseFormat
+ * @purpose: reads the name of a format, as given to --format
+ *
+ * @preconditions: none
+ * @postconditions: format is the named format, if the name is one
+ *
+ * @parameters: the name, and where to store the format
+ * @returns: true iff the name is "text", "tsv" or "json"
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool ResultWriter::parseFormat(const string &name, Format &format) {
+    if (name == "text") {
+        format = TEXT;
+    }
+    else if (name == "tsv") {
+        format = TSV;
+    }
+    else if (name == "json") {
+        format = JSON;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+ResultWriter::Format ResultWriter::getFormat() const {
+    return format;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: beginPath, step and endPath
+ * @purpose: write a path, one collaboration at a time
+ *
+ * @preconditions: steps are written between a beginPath and an endPath,
+ *                 each starting where the last one ended
+ * @postconditions: the collaboration, or the start or end of the path, is
+ *                  in the buffer
+ *
+ * @parameters: for step, the ids and names of the two Artists, and the
+ *              song they collaborated in
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::beginPath() {
+    firstStep = true;
+    if (format == JSON) {
+        buffer += "{\"path\": [";
+    }
+}
+
+void ResultWriter::step(CollabGraph::VertexId from, string_view fromName,
+                        CollabGraph::VertexId to, string_view toName,
+                        string_view song) {
+    if (format == TEXT) {
+        buffer += '"';
+        buffer += fromName;
+        buffer += "\" collaborated with \"";
+        buffer += toName;
+        buffer += "\" in \"";
+        buffer += song;
+        buffer += "\".\n";
+    }
+    else if (format == TSV) {
+        buffer += "step\t";
+        appendNumber(from);
+        buffer += '\t';
+        appendTsv(fromName);
+        buffer += '\t';
+        appendNumber(to);
+        buffer += '\t';
+        appendTsv(toName);
+        buffer += '\t';
+        appendTsv(song);
+        buffer += '\n';
+    }
+    else {
+        buffer += firstStep ? "{\"from\": " : ", {\"from\": ";
+        appendNumber(from);
+        buffer += ", \"from_name\": ";
+        appendJson(fromName);
+        buffer += ", \"to\": ";
+        appendNumber(to);
+        buffer += ", \"to_name\": ";
+        appendJson(toName);
+        buffer += ", \"song\": ";
+        appendJson(song);
+        buffer += '}';
+    }
+    firstStep = false;
+}
+
+void ResultWriter::endPath() {
+    if (format == TEXT) {
+        buffer += "***\n";
+    }
+    else if (format == TSV) {
+        buffer += "end\n";
+    }
+    else {
+        buffer += "]}\n";
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: noPath
+ * @purpose: write that two Artists have no path between them
+ *
+ * @preconditions: none
+ * @postconditions: the result is in the buffer
+ *
+ * @parameters: the names of the two Artists, as given
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::noPath(string_view source, string_view dest) {
+    if (format == TEXT) {
+        buffer += "A path does not exist between \"";
+        buffer += source;
+        buffer += "\" and \"";
+        buffer += dest;
+        buffer += "\".\n";
+    }
+    else if (format == TSV) {
+        buffer += "no_path\t";
+        appendTsv(source);
+        buffer += '\t';
+        appendTsv(dest);
+        buffer += '\n';
+    }
+    else {
+        buffer += "{\"no_path\": {\"source\": ";
+        appendJson(source);
+        buffer += ", \"dest\": ";
+        appendJson(dest);
+        buffer += "}}\n";
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: notFound
+ * @purpose: write that an Artist (or song) is not in the dataset
+ *
+ * @preconditions: none
+ * @postconditions: the result is in the buffer
+ *
+ * @parameters: the name, as given
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::notFound(string_view name) {
+    if (format == TEXT) {
+        buffer += '"';
+        buffer += name;
+        buffer += "\" was not found in the dataset :(\n";
+    }
+    else if (format == TSV) {
+        buffer += "not_found\t";
+        appendTsv(name);
+        buffer += '\n';
+    }
+    else {
+        buffer += "{\"not_found\": ";
+        appendJson(name);
+        buffer += "}\n";
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: degrees
+ * @purpose: write the bounds the landmarks give on two Artists' distance
+ *
+ * @preconditions: the Artists are connected as far as the landmarks know
+ * @postconditions: the result is in the buffer
+ *
+ * @parameters: the names of the two Artists, as given, and the bounds
+ *              (upper is CollabGraph::NO_BOUND if there is none)
+ *
+ * @notes: the text is exact when the bounds match, and otherwise gives
+ *         the range, or only the lower bound
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::degrees(string_view source, string_view dest,
+                           uint32_t lower, uint32_t upper) {
+    bool bounded = (upper != CollabGraph::NO_BOUND);
+    if (format == TEXT) {
+        buffer += '"';
+        buffer += source;
+        buffer += "\" and \"";
+        buffer += dest;
+        buffer += "\" are ";
+        if (not bounded) {
+            buffer += "at least ";
+        }
+        else if (lower != upper) {
+            appendNumber(lower);
+            buffer += " to ";
+        }
+        uint32_t shown = bounded ? upper : lower;
+        appendNumber(shown);
+        buffer += shown == 1 ? " degree apart.\n" : " degrees apart.\n";
+    }
+    else if (format == TSV) {
+        buffer += "degrees\t";
+        appendTsv(source);
+        buffer += '\t';
+        appendTsv(dest);
+        buffer += '\t';
+        appendNumber(lower);
+        buffer += '\t';
+        if (bounded) {
+            appendNumber(upper);
+        }
+        buffer += '\n';
+    }
+    else {
+        buffer += "{\"degrees\": {\"source\": ";
+        appendJson(source);
+        buffer += ", \"dest\": ";
+        appendJson(dest);
+        buffer += ", \"lower\": ";
+        appendNumber(lower);
+        buffer += ", \"upper\": ";
+        if (bounded) {
+            appendNumber(upper);
+        }
+        else {
+            buffer += "null";
+        }
+        buffer += "}}\n";
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: message
+ * @purpose: write any other one-line result, such as an unknown command
+ *
+ * @preconditions: none
+ * @postconditions: the line is in the buffer
+ *
+ * @parameters: the line, without its newline
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::message(string_view line) {
+    if (format == TEXT) {
+        buffer += line;
+        buffer += '\n';
+    }
+    else if (format == TSV) {
+        buffer += "message\t";
+        appendTsv(line);
+        buffer += '\n';
+    }
+    else {
+        buffer += "{\"message\": ";
+        appendJson(line);
+        buffer += "}\n";
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: append
+ * @purpose: adds output that was already formatted, such as the results a
+ *           thread of a batch wrote
+ *
+ * @preconditions: none
+ * @postconditions: the output is in the buffer, after everything before it
+ *
+ * @parameters: the output
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::append(const string &formatted) {
+    buffer += formatted;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: text and clear
+ * @purpose: give a writer without a stream's output to the caller, and
+ *           empty it to reuse its buffer
+ *
+ * @preconditions: none
+ * @postconditions: none / the buffer is empty, keeping its capacity
+ *
+ * @parameters: none
+ * @returns: the output since the last clear / none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+const string &ResultWriter::text() const {
+    return buffer;
+}
+
+void ResultWriter::clear() {
+    buffer.clear();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: flush and flushIfFull
+ * @purpose: write the buffer to the stream in one piece, always or only
+ *           once it holds FLUSH_SIZE bytes
+ *
+ * @preconditions: none
+ * @postconditions: if written, the buffer is empty; a writer without a
+ *                  stream keeps its output
+ *
+ * @parameters: none
+ *
+ * @notes: flush also flushes the stream, so output meant for a person
+ *         shows up as soon as the command that printed it is done
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::flush() {
+    if (sink == nullptr) {
+        return;
+    }
+    sink->write(buffer.data(), buffer.size());
+    sink->flush();
+    buffer.clear();
+}
+
+void ResultWriter::flushIfFull() {
+    if (sink != nullptr and buffer.size() >= FLUSH_SIZE) {
+        sink->write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: stream
+ * @purpose: gives a command that prints its own text (print, stats and the
+ *           distances commands) the stream, after what came before it
+ *
+ * @preconditions: the writer has a stream
+ * @postconditions: the buffer has been written to it, so output stays in
+ *                  order
+ *
+ * @parameters: none
+ * @returns: the stream
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+ostream &ResultWriter::stream() {
+    sink->write(buffer.data(), buffer.size());
+    buffer.clear();
+    return *sink;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: appendNumber, appendTsv and appendJson
+ * @purpose: add a number, a TSV field or a JSON string to the buffer
+ *
+ * @preconditions: none
+ * @postconditions: the buffer ends with the number, with the field's tabs,
+ *                  newlines and backslashes escaped, or with the text in
+ *                  quotes, with quotes, backslashes and control characters
+ *                  escaped
+ *
+ * @parameters: the number or text
+ *
+ * @notes: other bytes are copied as they are, so names that are not UTF-8
+ *         stay exactly as the data file has them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void ResultWriter::appendNumber(uint64_t number) {
+    char digits[20];
+    char *end = to_chars(digits, digits + sizeof(digits), number).ptr;
+    buffer.append(digits, end - digits);
+}
+
+void ResultWriter::appendTsv(string_view field) {
+    for (char c : field) {
+        if (c == '\t') {
+            buffer += "\\t";
+        }
+        else if (c == '\n') {
+            buffer += "\\n";
+        }
+        else if (c == '\\') {
+            buffer += "\\\\";
+        }
+        else {
+            buffer += c;
+        }
+    }
+}
+
+void ResultWriter::appendJson(string_view text) {
+    const char *HEX = "0123456789abcdef";
+    buffer += '"';
+    for (unsigned char c : text) {
+        if (c == '"' or c == '\\') {
+            buffer += '\\';
+            buffer += c;
+        }
+        else if (c < 0x20) {
+            buffer += "\\u00";
+            buffer += HEX[c >> 4];
+            buffer += HEX[c & 15];
+        }
+        else {
+            buffer += c;
+        }
+    }
+    buffer += '"';
+}
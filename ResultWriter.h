@@ -0,0 +1,84 @@
+/*
+ * ResultWriter.h
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Interface for ResultWriter. A ResultWriter formats the results of
+ * queries (paths, missing artists and other one-line messages) into one
+ * reusable buffer, and passes the buffer on to its stream in large chunks
+ * rather than a few bytes at a time. Results are written as the text
+ * SixDegrees has always printed, or, for programs reading them, as
+ * tab-separated rows or as one JSON object per line, both with artist ids.
+ *
+ */
+
+#ifndef _RESULT_WRITER_H_
+#define _RESULT_WRITER_H_
+
+#include "CollabGraph.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+class ResultWriter {
+
+public:
+    // How results are written: the human-readable text, tab-separated
+    // rows, or JSON lines
+    enum Format { TEXT, TSV, JSON };
+
+    // Constructors: one that only keeps its output, for the caller to take
+    // with text(), and one that passes it on to a stream
+    ResultWriter(Format format);
+    ResultWriter(Format format, ostream &sink);
+
+    // Reads a format's name ("text", "tsv" or "json")
+    static bool parseFormat(const string &name, Format &format);
+    Format getFormat() const;
+
+    // The results of queries. A path is beginPath, a step for each
+    // collaboration on it, in order, then endPath
+    void beginPath();
+    void step(CollabGraph::VertexId from, string_view fromName,
+              CollabGraph::VertexId to, string_view toName, string_view song);
+    void endPath();
+    void noPath(string_view source, string_view dest);
+    void notFound(string_view name);
+    void degrees(string_view source, string_view dest, uint32_t lower,
+                 uint32_t upper);
+    void message(string_view line);
+
+    // Output formatted elsewhere, such as a batch's results, in order
+    void append(const string &formatted);
+
+    // The buffer, for a writer without a stream
+    const string &text() const;
+    void clear();
+
+    // Passing the buffer on: always, only once it is big enough to be
+    // worth a write, or before a command prints to the stream itself
+    void flush();
+    void flushIfFull();
+    ostream &stream();
+
+private:
+    Format format;
+    ostream *sink;
+    string buffer;
+
+    // Whether the path being written has had a step yet
+    bool firstStep = true;
+
+    // Appending a name or number in each format
+    void appendNumber(uint64_t number);
+    void appendTsv(string_view field);
+    void appendJson(string_view text);
+};
+
+#endif /* _RESULT_WRITER_H_ */
@@ -15,10 +15,32 @@
 
 #include "Artist.h"
 #include "CollabGraph.h"
+#include "ResultWriter.h"
 #include "SixDegrees.h"
+#include "Stats.h"
+#include "TraversalEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
-#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -27,31 +49,94 @@ using namespace std;
  * @purpose: initialize a SixDegrees instance
  *
  * @preconditions: none
- * @postconditions: our numFiles, inputFile, outputFile variables are updated
+ * @postconditions: our numFiles, numThreads, directionOptimizing,
+ *                  numLandmarks, format, socketPath, inputFile,
+ *                  outputFile variables are updated, or, given
+ *                  "--build-snapshot data graph",
+ *                  the snapshot is written and the program exits
  *
  * @parameters: number of command line arguments and their positions
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-SixDegrees::SixDegrees(int argc, char *argv[]) {
-    // Convert arguments indexing to solely focus on arguments, not the program
-    numFiles = argc - 1;
+SixDegrees::SixDegrees(int argc, char *argv[]) : engine(CG) {
+    // The optional "--threads N", "--direction-optimizing", 
+    // "--landmarks K", "--format F" and "--serve socketPath" come first
+    int first = 1;
+    bool badFormat = false;
+    bool badCount = false;
+    while (true) {
+        if (argc > first + 1 and string(argv[first]) == "--threads") {
+            badCount = not parseCount(argv[first + 1], numThreads) or 
+                       badCount;
+            first += 2;
+        }
+        else if (argc > first + 1 and string(argv[first]) == "--landmarks") {
+            badCount = not parseCount(argv[first + 1], numLandmarks) or 
+                       badCount;
+            first += 2;
+        }
+        else if (argc > first + 1 and string(argv[first]) == "--format") {
+            badFormat = not ResultWriter::parseFormat(argv[first + 1], 
+                                                      format);
+            first += 2;
+        }
+        else if (argc > first + 1 and string(argv[first]) == "--serve") {
+            socketPath = argv[first + 1];
+            first += 2;
+        }
+        else if (argc > first and 
+                 string(argv[first]) == "--direction-optimizing") {
+            directionOptimizing = true;
+            first++;
+        }
+        else {
+            break;
+        }
+    }
+    engine.setDirectionOptimizing(directionOptimizing);
+    engine.setExclusionSets(&exclusionSets);
+    
+    // "--build-snapshot data graph" converts a data file and does nothing else
+    bool snapshot = argc > first and string(argv[first]) == "--build-snapshot";
+    if (snapshot) {
+        first++;
+    }
+    
+    // Convert arguments indexing to solely focus on the files
+    numFiles = argc - first;
     
     // If program usage is incorrect, inform user and cease operations
-    if (numFiles < 1 or numFiles > 3) {
-        cerr << "Usage: SixDegrees dataFile [commandFile] [outputFile]\n";
+    if (numFiles < 1 or numFiles > 3 or numThreads < 1 or badCount or
+        badFormat or (snapshot and numFiles != 2) or
+        (not socketPath.empty() and (snapshot or numFiles != 1))) {
+        cerr << "Usage: SixDegrees [--threads N] [--direction-optimizing] "
+             << "[--landmarks K]\n"
+             << "                  [--format text|tsv|json] "
+             << "dataFile [commandFile] [outputFile]\n"
+             << "       SixDegrees [--threads N] [--direction-optimizing] "
+             << "[--landmarks K]\n"
+             << "                  [--format text|tsv|json] "
+             << "--serve socketPath dataFile\n"
+             << "       SixDegrees [--threads N] [--landmarks K] "
+             << "--build-snapshot dataFile snapshotFile\n";
         exit(EXIT_FAILURE);
     }
     
+    if (snapshot) {
+        buildSnapshot(argv[first], argv[first + 1]);
+        exit(EXIT_SUCCESS);
+    }
+    
     // Initialize file names for future reading
-    dataFile = argv[1];
+    dataFile = argv[first];
     
     inputFile = "";
     if (numFiles > 1) {
-        inputFile = argv[2];
+        inputFile = argv[first + 1];
     }
     
     outputFile = "";
     if (numFiles > 2) {
-        outputFile = argv[3];
+        outputFile = argv[first + 2];
     }
 }
 
@@ -68,6 +153,32 @@ SixDegrees::~SixDegrees() {
 
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: parseCount
+ * @purpose: reads the number given to --threads or --landmarks
+ *
+ * @preconditions: none
+ * @postconditions: count is the number, if the text is one
+ *
+ * @parameters: the text, and where to store the number
+ * @returns: true iff the text is a whole number, in decimal, from 0 to
+ *           INT_MAX, with nothing before or after it
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool SixDegrees::parseCount(const char *text, int &count) {
+    if (not isdigit((unsigned char) text[0])) {
+        return false;
+    }
+    
+    char *end;
+    errno = 0;
+    long number = strtol(text, &end, 10);
+    if (*end != '\0' or errno == ERANGE or number > INT_MAX) {
+        return false;
+    }
+    count = number;
+    return true;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * @function: run
  * @purpose: populate the CollabGraph with data from the provided data file,
@@ -75,16 +186,21 @@ SixDegrees::~SixDegrees() {
  *
  * @preconditions: provided data file is valid
  * @postconditions: the CollabGraph is populated, and SixDegrees will read
- *                  from user/file input and print to console/an output file
+ *                  from user/file input and print to console/an output file,
+ *                  or serve clients on socketPath until it is stopped
  *
  * @parameters: none
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void SixDegrees::run() {
     // Populate the graph with data from the data file
-    importData();
+    load();
     
+    // A server answers its clients instead of standard input
+    if (not socketPath.empty()) {
+        serve();
+    }
     // If no extra files are provided, receive user input and print to console
-    if (numFiles == 1) {
+    else if (numFiles == 1) {
         commandLoop(cin, cout);
     }
     // If an input file is provided, use its contents for input
@@ -109,70 +225,347 @@ void SixDegrees::run() {
     }
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: load
+ * @purpose: populates the CollabGraph from the data file (or snapshot),
+ *           and builds the landmarks if --landmarks asked for them
+ *
+ * @preconditions: none
+ * @postconditions: the CollabGraph is populated and frozen, or the program
+ *                  has exited with an error
+ *
+ * @parameters: none
+ * @returns: the graph, which SixDegreesBench times its commands on
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CollabGraph &SixDegrees::load() {
+    importData();
+    addLandmarks();
+    return CG;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: answerBatches
+ * @purpose: answers commands the way a command file given with
+ *           "--threads threads" is answered, in batches of queries
+ *
+ * @preconditions: the graph has been loaded
+ * @postconditions: the commands' output is printed, exactly as commandLoop
+ *                  would print it, and quit is reset so the next call
+ *                  answers its commands too
+ *
+ * @parameters: where to read the commands from, where to print output,
+ *              and the number of threads to answer queries on
+ *
+ * @notes: unlike commandLoop, one thread also goes through batchLoop, so
+ *         ThreadBench times the same code for every number of threads
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::answerBatches(istream &input, ostream &output, 
+                               int threads) {
+    numThreads = threads;
+    quit = false;
+    
+    ResultWriter writer(format, output);
+    batchLoop(input, writer);
+    writer.flush();
+    quit = false;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: buildSnapshot
+ * @purpose: converts a data file into a binary snapshot, which later runs
+ *           can load in place of the data file
+ *
+ * @preconditions: none
+ * @postconditions: the snapshot is written and has been read back and
+ *                  checked, or the program has exited with an error
+ *
+ * @parameters: the data file to read and the snapshot file to write
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::buildSnapshot(const string &data, const string &snapshot) {
+    dataFile = data;
+    importData();
+    addLandmarks();
+    
+    try {
+        CG.save_snapshot(snapshot);
+        
+        // Read the file back, checksum and all, before reporting success
+        CG.load_snapshot(snapshot, true);
+    }
+    catch (const runtime_error &e) {
+        cerr << e.what() << "\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * @function: importData
- * @purpose: populates the CollabGraph
+ * @purpose: populates the CollabGraph, from a text data file or a binary
+ *           snapshot made with --build-snapshot
  *
  * @preconditions: none
- * @postconditions: the CollabGraph is populated
+ * @postconditions: the CollabGraph is populated and frozen
  *
  * @parameters: none
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void SixDegrees::importData() {
-    // Turn the provided data file into an input stream
-    ifstream infile;
-    infile.open(dataFile);
+    // Snapshots are mapped as they are, without parsing or building
+    if (CollabGraph::is_snapshot(dataFile)) {
+        try {
+            CG.load_snapshot(dataFile, false);
+        }
+        catch (const runtime_error &e) {
+            cerr << e.what() << "\n";
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+    
+    // Map the data file so records can be read without copying them
+    int fd = open(dataFile.c_str(), O_RDONLY);
+    struct stat info;
     
     // If the data file is invalid, cease operations
-    if (infile.fail()) {
+    if (fd < 0 or fstat(fd, &info) != 0) {
         cerr << dataFile << " cannot be opened.\n";
         exit(EXIT_FAILURE);
     }
     
+    size_t size = info.st_size;
+    void *mapping = nullptr;
+    if (size > 0) {
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            cerr << dataFile << " cannot be opened.\n";
+            exit(EXIT_FAILURE);
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    
+    // Each record goes straight into the graph, which ends up frozen
+    const char *text = static_cast<const char *>(mapping);
+    try {
+        if (numThreads > 1) {
+            getArtists(text, text + size);
+        }
+        else {
+            CollabGraph::Builder builder(CG);
+            getArtists(text, text + size, builder);
+            builder.finish();
+        }
+    }
+    catch (const runtime_error &e) {
+        cerr << dataFile << ": " << e.what() << "\n";
+        exit(EXIT_FAILURE);
+    }
+    
+    if (mapping != nullptr) {
+        munmap(mapping, size);
+    }
+}
 
-    vector<Artist> artists = getArtists(infile);
-        
-    // If the file was empty, avoid calling populate_graph bad allocation
-    if (artists.empty()) {
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: addLandmarks
+ * @purpose: builds the landmark distances asked for with --landmarks K
+ *
+ * @preconditions: the CollabGraph is populated and frozen
+ * @postconditions: the graph has K landmarks (or fewer, if it runs out of
+ *                  candidates), or keeps whatever landmarks its snapshot
+ *                  had if --landmarks was not given
+ *
+ * @parameters: none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::addLandmarks() {
+    if (numLandmarks < 0) {
         return;
     }
+    CG.build_landmarks(numLandmarks, numThreads);
+}
 
-    // Populate the graph with the data from the provided file
-    CG.populate_graph(artists);
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: getArtists
+ * @purpose: scans the text of a data file and hands each artist and its
+ *           songs to the graph builder as soon as its record ends
+ *
+ * @preconditions: none
+ * @postconditions: every artist in the text has been added to the builder,
+ *                  in file order
+ *
+ * @parameters: the start and end of the text, and the builder to fill
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::getArtists(const char *begin, const char *end,
+                            CollabGraph::Builder &builder) {
+    STATS_TIMER(PARSE);
+    
+    vector<string_view> songs;
+    string_view name;
+    const char *at = begin;
     
-    infile.close();
+    while (nextRecord(at, end, name, songs)) {
+        builder.add_artist(name, songs);
+    }
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: getArtitsts
- * @purpose: extracts Artists and their info from the data file and puts 
- *           them into a vector to be used for populating the graph
+ * @function: getArtists
+ * @purpose: parses the text of a data file on numThreads threads and
+ *           builds the graph from it in parallel
  *
- * @preconditions: a valid data file is provided
- * @postconditions: none
+ * @preconditions: numThreads is more than 1
+ * @postconditions: the CollabGraph holds exactly the graph the streaming
+ *                  getArtists would have built, frozen
+ *
+ * @parameters: the start and end of the text
  *
- * @parameters: where to read input from
+ * @notes: the text is cut into pieces at record boundaries, several per
+ *         thread so the threads stay busy, and each piece is parsed on
+ *         its own by the same rules as the streaming getArtists
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-vector<Artist> SixDegrees::getArtists(istream &input) {
-    string line;
-    vector<Artist> artists;
+void SixDegrees::getArtists(const char *begin, const char *end) {
+    STATS_TIMER(PARSE);
+    
+    // Small enough pieces that none holds more than 2^32 songs
+    const size_t MAX_CHUNK = 64 << 20;
+    size_t size = end - begin;
+    size_t numChunks = max<size_t>(4 * numThreads, size / MAX_CHUNK + 1);
+    
+    vector<const char *> bounds(numChunks + 1, end);
+    bounds[0] = begin;
+    for (size_t c = 1; c < numChunks; c++) {
+        bounds[c] = recordStart(bounds[c - 1], end, 
+                                begin + c * size / numChunks);
+    }
     
-    // Read file data, and create the artists until file data is exhausted
-    while (getline(input, line)) {
-        if (input.eof()) {
-            return artists;
+    vector<CollabGraph::Records> chunks(numChunks);
+    atomic<size_t> next(0);
+    vector<thread> threads;
+    
+    for (int t = 0; t < numThreads; t++) {
+        threads.push_back(thread([&]() {
+            vector<string_view> songs;
+            string_view name;
+            for (size_t c = next++; c < numChunks; c = next++) {
+                const char *at = bounds[c];
+                while (nextRecord(at, bounds[c + 1], name, songs)) {
+                    chunks[c].names.push_back(name);
+                    chunks[c].songs.insert(chunks[c].songs.end(), 
+                                           songs.begin(), songs.end());
+                    chunks[c].song_offsets.push_back(chunks[c].songs.size());
+                }
+            }
+            STATS_FLUSH();
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    
+    CG.populate_graph(chunks, numThreads);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nextRecord
+ * @purpose: reads the next artist's record from a block of text
+ *
+ * @preconditions: none
+ * @postconditions: at is just past the record
+ *
+ * @parameters: the position to read from, the end of the text, and where
+ *              to store the artist's name and songs
+ * @returns: true if there was another record, false at the end of the text
+ *
+ * @notes: 1) a record is a name line followed by song lines and ended by a
+ *            "*" line. The name is also the artist's first song, as it
+ *            always has been
+ *         2) the last record may end at the end of the text instead of at
+ *            a "*", and the last line needs no newline
+ *         3) blank lines where a record would start are skipped
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool SixDegrees::nextRecord(const char *&at, const char *end, 
+                            string_view &name, vector<string_view> &songs) {
+    do {
+        if (at == end) {
+            return false;
         }
-        Artist newArtist(line);
-        
-        // Given a marker, start filling in artists' info
-        while (line != "*") {
-            newArtist.add_song(line);
-            getline(input, line);
+        name = nextLine(at, end);
+    } while (name.empty());
+    
+    // Gather the record's lines until its marker or the end of the text
+    songs.clear();
+    string_view line = name;
+    while (line != "*") {
+        songs.push_back(line);
+        if (at == end) {
+            break;
         }
-        artists.push_back(newArtist);
+        line = nextLine(at, end);
     }
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: recordStart
+ * @purpose: finds a place to cut a data file's text between two records
+ *
+ * @preconditions: from is not before the start of the text
+ * @postconditions: none
+ *
+ * @parameters: the start and end of the text, and where to start looking
+ * @returns: the start of the first line, at or after from, that surely
+ *           begins a record, or the end of the text if there is none
+ *
+ * @notes: a "*" line could also be the name of an artist, so the cut is
+ *         only made after a "*" whose previous line is neither blank nor
+ *         "*". That line is inside a record, so the "*" must end it
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+const char *SixDegrees::recordStart(const char *begin, const char *end,
+                                    const char *from) {
+    if (from <= begin) {
+        return begin;
+    }
+    
+    // Move to the start of the next whole line
+    const char *at = static_cast<const char *>(
+        memchr(from - 1, '\n', end - (from - 1)));
+    if (at == nullptr) {
+        return end;
+    }
+    at++;
     
-    return artists;
+    string_view previous = "*";
+    while (at < end) {
+        string_view line = nextLine(at, end);
+        if (line == "*" and previous != "*" and not previous.empty()) {
+            return at;
+        }
+        previous = line;
+    }
+    return end;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nextLine
+ * @purpose: splits the next line off of a block of text
+ *
+ * @preconditions: at is before end
+ * @postconditions: at is just past the line's newline, or at end if the
+ *                  line has none
+ *
+ * @parameters: the position to read from, and the end of the text
+ * @returns: the line, without its newline
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+string_view SixDegrees::nextLine(const char *&at, const char *end) {
+    const char *start = at;
+    const char *newline = static_cast<const char *>(
+        memchr(start, '\n', end - start));
+    
+    if (newline == nullptr) {
+        at = end;
+        return string_view(start, end - start);
+    }
+    at = newline + 1;
+    return string_view(start, newline - start);
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -186,308 +579,1009 @@ vector<Artist> SixDegrees::getArtists(istream &input) {
  * @parameters: where to read input from and where to print output
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 void SixDegrees::commandLoop(istream &input, ostream &output) {
+    ResultWriter writer(format, output);
+    
+    // Command files can be answered in parallel, in batches
+    if (numThreads > 1 and numFiles > 1) {
+        batchLoop(input, writer);
+        writer.flush();
+        return;
+    }
+    
     string command;
     
     // Accept input until program is quit or input file is completely read
     while (not quit and getline(input, command)) {
+        if (command == "quit") {
+            quit = true;
+        }
+        else {
+            runCommand(command, input, writer);
+        }
+        
+        // A person typing commands sees each result at once; a command
+        // file's results are written in large chunks
+        if (numFiles == 1) {
+            writer.flush();
+        }
+        else {
+            writer.flushIfFull();
+        }
+    }
+    writer.flush();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: runCommand
+ * @purpose: executes one command other than quit, reading the lines that
+ *           follow it
+ *
+ * @preconditions: the graph is frozen
+ * @postconditions: the command's output, or an error message, is printed
+ *
+ * @parameters: the command, where to read its lines from and where to
+ *              print output
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::runCommand(const string &command, istream &input, 
+                            ResultWriter &output) {
+    if (command == "print") {
+        CG.print_graph(output.stream(), numThreads);
+    }
+    else if (command == "stats") {
+        Stats::print(output.stream());
+    }
+    else if (isTraversal(command)) {
+        query.command = command;
+        readQuery(input, query);
+        engine.run(query, output);
+    }
+    else if (isDistances(command)) {
+        distances(command, input, output.stream());
+    }
+    else if (isUpdate(command)) {
+        update(command, input, output);
+    }
+    else if (isExclude(command)) {
+        exclude(command, input, output);
+    }
+    else {
+        output.message(command + " is not a command. Please try again.");
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: batchLoop
+ * @purpose: driver function for command files when running with several
+ *           threads. Traversal queries are read in batches and answered in
+ *           parallel, one TraversalEngine per thread, and their results are
+ *           printed in the order the queries were given
+ *
+ * @preconditions: program usage is correct and the graph is frozen
+ * @postconditions: program performs desired tasks, with exactly the output
+ *                  commandLoop would have produced
+ *
+ * @parameters: where to read input from and where to print output
+ *
+ * @notes: print, stats, quit, the distances commands, exclude and the
+ *         commands that add to the graph end a batch early, so they happen
+ *         after every query before them has been answered and printed, and
+ *         before any query after them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::batchLoop(istream &input, ResultWriter &output) {
+    const size_t BATCH_SIZE = 4096;
+    
+    vector<Query> batch(BATCH_SIZE);
+    vector<string> results(BATCH_SIZE);
+    string command;
+    bool more = true;
+    
+    while (not quit and more) {
+        size_t count = 0;
+        string pending;
+        
+        // Gather queries until the batch is full or a command needs the graph
+        while (count < BATCH_SIZE and not quit and pending.empty()) {
+            if (not getline(input, command)) {
+                more = false;
+                break;
+            }
             if (command == "quit") {
                 quit = true;
             }
-            else if (command == "print") {
-                CG.print_graph(output);
-            }
-            else if (command == "bfs" or 
-                     command == "dfs" or 
-                     command == "not") {
-                traversalHelper(command, input, output);
+            else if (command == "print" or command == "stats" or 
+                     isDistances(command) or isUpdate(command) or 
+                     isExclude(command)) {
+                pending = command;
             }
             else {
-                output << command << " is not a command. Please try again.\n";
+                batch[count].command = command;
+                if (isTraversal(command)) {
+                    readQuery(input, batch[count]);
+                }
+                count++;
             }
         }
+        
+        runBatch(batch, count, results);
+        for (size_t i = 0; i < count; i++) {
+            output.append(results[i]);
+            output.flushIfFull();
+        }
+        
+        if (not pending.empty()) {
+            runCommand(pending, input, output);
+        }
+    }
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: traversalHelper
- * @purpose: gathers data for the traversal functions
+ * @function: runBatch
+ * @purpose: answers a batch of commands on numThreads threads, each with its
+ *           own TraversalEngine, sharing the read-only graph
  *
- * @preconditions: program usage is correct
- * @postconditions: desired traversal function is called with appropriate info
+ * @preconditions: the graph is frozen
+ * @postconditions: results[i] holds the output of batch[i], for every i less
+ *                  than count
  *
- * @parameters: which command was called, where to receive input from and 
- *              where to print output to
+ * @parameters: the commands, how many of them to run, and where to store
+ *              their output
+ *
+ * @notes: with one thread the commands are answered on this one, without
+ *         starting another
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::traversalHelper(string command, istream &input, 
-                                 ostream &output) {
-    CG.clear_metadata();
+void SixDegrees::runBatch(const vector<Query> &batch, size_t count,
+                          vector<string> &results) {
+    addWorkers();
     
-    // Initialize variables to store input
-    string a1, a2;
-    getline(input, a1);
-    getline(input, a2);
+    // Each thread claims the next unanswered command until none are left
+    atomic<size_t> next(0);
+    auto answer = [&](int t) {
+        ResultWriter out(format);
+        for (size_t i = next++; i < count; i = next++) {
+            out.clear();
+            if (isTraversal(batch[i].command)) {
+                workers[t].run(batch[i], out);
+            }
+            else {
+                out.message(batch[i].command + 
+                            " is not a command. Please try again.");
+            }
+            results[i].assign(out.text());
+        }
+        STATS_FLUSH();
+    };
     
-    // Call the appropriate function based on input
-    if (command == "bfs") {
-        bfsWrapper(a1, a2, output);
+    if (numThreads == 1) {
+        answer(0);
+        return;
     }
-    else if (command == "dfs") {
-        dfsWrapper(a1, a2, output);
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.push_back(thread(answer, t));
     }
-    else {
-        notWrapper(a1, a2, input, output);
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
     }
-    // Print the result
-    printPath(a1, a2, output);
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: bfsWrapper
- * @purpose: checks if Artists to traverse between are valid, and if either of
- *           them were excluded from the not function/visited already
+ * @function: addWorkers
+ * @purpose: makes sure there is one TraversalEngine per thread
  *
  * @preconditions: none
- * @postconditions: error messages are printed or traversal begins
+ * @postconditions: workers has at least numThreads engines, set up like
+ *                  the main engine
+ *
+ * @parameters: none
  *
- * @parameters: Artists provided by input and where to print error message to
+ * @notes: the engines are kept between batches so their buffers are reused
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::bfsWrapper(const Artist& a1, const Artist& a2, 
-                            ostream &output) {
-    // Check if Artists are vertices in the graph
-    if (not validArtists(a1, a2, output)) {
-        return;
+void SixDegrees::addWorkers() {
+    while (workers.size() < (size_t) numThreads) {
+        workers.push_back(TraversalEngine(CG));
+        workers.back().setDirectionOptimizing(directionOptimizing);
+        workers.back().setExclusionSets(&exclusionSets);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: isTraversal
+ * @purpose: determines whether a command is answered by a TraversalEngine
+ *
+ * @preconditions: none
+ * @postconditions: none
+ *
+ * @parameters: the command
+ * @returns: true iff the command is bfs, dfs, not, bibfs, binot, bfs-many,
+ *           incl or degrees, or one of the first five followed by a space
+ *           and the name of an exclusion set
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool SixDegrees::isTraversal(const string &command) {
+    size_t space = command.find(' ');
+    if (space != string::npos) {
+        string_view base(command.data(), space);
+        return space + 1 < command.size() and
+               (base == "bfs" or base == "dfs" or base == "not" or 
+                base == "bibfs" or base == "binot");
     }
+    return command == "bfs" or 
+           command == "dfs" or 
+           command == "not" or
+           command == "bibfs" or
+           command == "binot" or
+           command == "bfs-many" or
+           command == "incl" or
+           command == "degrees";
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: readQuery
+ * @purpose: reads the input lines that follow a traversal command
+ *
+ * @preconditions: query.command has been set
+ * @postconditions: the query holds both artists and, for not and binot,
+ *                  the artists to exclude, or for incl the artist or song
+ *                  to pass through; for bfs-many it holds the source and
+ *                  the targets instead. An exclusion set named after the
+ *                  command is moved into exclusionSet
+ *
+ * @parameters: where to read input from and the query to fill in
+ *
+ * @notes: reads into the query's existing strings, so reusing a Query
+ *         avoids reallocating them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::readQuery(istream &input, Query &query) {
+    query.exclusionSet.clear();
+    size_t space = query.command.find(' ');
+    if (space != string::npos) {
+        query.exclusionSet.assign(query.command, space + 1, string::npos);
+        query.command.resize(space);
+    }
+    
+    getline(input, query.source);
     
-    // If either of the Artists are excluded by the not function, stop 
-    else if (CG.is_marked(a1) or CG.is_marked(a2)) {
+    query.numExcluded = 0;
+    query.numTargets = 0;
+    if (query.command == "bfs-many") {
+        readNames(input, query.targets, query.numTargets);
         return;
     }
     
-    // If conditions are good, call the traversal function
-    bfs(a1, a2);
+    getline(input, query.dest);
+    
+    if (query.command == "incl") {
+        getline(input, query.through);
+        return;
+    }
+    if (query.command != "not" and query.command != "binot") {
+        return;
+    }
+    readNames(input, query.excluded, query.numExcluded);
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: bfs
- * @purpose: traverses by repeatedly visiting all neighbors of a node
+ * @function: readNames
+ * @purpose: reads a list of artists ended by a "*" line (or the end of
+ *           input)
  *
- * @preconditions: the Artists to traverse between are valid
- * @postconditions: predecessors for all visited nodes are set or error
- *                  message is printed
+ * @preconditions: none
+ * @postconditions: the first count strings of names are the artists read
  *
- * @parameters: Artists provided by input
+ * @parameters: where to read input from, the strings to read into, and
+ *              where to store how many were read
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::bfs(const Artist& a1, const Artist& a2) {
-    queue<Artist> pQueue;
-    
-    CG.mark_vertex(a1);
-    pQueue.push(a1);
-    
-    // Visit vertices until destination is reached or whole graph is traversed
-    while (not pQueue.empty()) {
-        Artist next = pQueue.front();
-        CG.mark_vertex(next);
-        
-        // If we have reached the destination, nothing else is needed
-        if (next == a2) {
-            return;
+void SixDegrees::readNames(istream &input, vector<string> &names,
+                           size_t &count) {
+    while (true) {
+        if (count == names.size()) {
+            names.push_back("");
         }
-        
-        vector<Artist> neighbors = CG.get_vertex_neighbors(next);
-        
-        // Update information for all unvisited neighbors
-        for(size_t i = 0; i < neighbors.size(); i++) {
-            if (not CG.is_marked(neighbors.at(i))) {
-                CG.mark_vertex(neighbors.at(i));
-                CG.set_predecessor(neighbors.at(i), next);
-                pQueue.push(neighbors.at(i));
-            }
+        string &name = names[count];
+        if (not getline(input, name) or name == "*") {
+            return;
         }
-        pQueue.pop();
+        count++;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: isUpdate
+ * @purpose: determines whether a command adds to the graph
+ *
+ * @preconditions: none
+ * @postconditions: none
+ *
+ * @parameters: the command
+ * @returns: true iff the command is add-artist or add-song
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool SixDegrees::isUpdate(const string &command) {
+    return command == "add-artist" or command == "add-song";
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: update
+ * @purpose: reads the lines that follow add-artist or add-song and adds
+ *           them to the graph in place, so that later commands see them
+ *           without the data file being read again
+ *
+ * @preconditions: the graph is frozen
+ * @postconditions: add-artist has added a new artist with the songs listed
+ *                  after it (ended by a "*" line); add-song has added one
+ *                  song to an existing artist. Either connects the artist
+ *                  to every artist that shares one of the songs
+ *
+ * @parameters: the command, where to read its lines from and where to
+ *              print any error
+ *
+ * @notes: nothing is printed unless the artist cannot be added to (an
+ *         add-song artist not in the dataset) or added (an add-artist
+ *         artist already in it, or an empty name)
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::update(const string &command, istream &input,
+                        ResultWriter &output) {
+    string name;
+    getline(input, name);
+    
+    size_t count = 0;
+    if (command == "add-artist") {
+        readNames(input, songs, count);
+    }
+    else {
+        songs.resize(max<size_t>(songs.size(), 1));
+        getline(input, songs[0]);
+        count = 1;
+    }
+    
+    bool exists = CG.get_vertex_id(name) != CollabGraph::NO_VERTEX;
+    if (command == "add-song" and not exists) {
+        output.notFound(name);
+        return;
+    }
+    if (command == "add-artist" and exists) {
+        output.message("\"" + name + "\" is already in the dataset.");
+        return;
+    }
+    if (command == "add-artist" and name.empty()) {
+        output.message("An artist cannot be added without a name.");
+        return;
+    }
+    
+    vector<string_view> views(songs.begin(), songs.begin() + count);
+    if (command == "add-artist") {
+        CG.add_artist(name, views);
+    }
+    else {
+        CG.add_song(name, views[0]);
+    }
+    
+    // Every exclusion set needs a bit for the new artist
+    for (auto &set : exclusionSets) {
+        set.second.resize((CG.vertex_count() + 63) / 64, 0);
     }
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: notWrapper
- * @purpose: marks excluded Artists as seen to avoid them in traversal then
- *           does a breadth first traversal of the graph
+ * @function: isExclude
+ * @purpose: determines whether a command defines an exclusion set
  *
  * @preconditions: none
- * @postconditions: predecessors for all visited nodes are set or error
- *                  message is printed
+ * @postconditions: none
  *
- * @parameters: Artists provided by input, an input stream for Artists 
- *              to exclude, and output stream for printing error messages
+ * @parameters: the command
+ * @returns: true iff the command is "exclude" followed by a space and the
+ *           set's name
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::notWrapper(const Artist& a1, const Artist& a2, 
-                            istream &input, ostream &output) {
-    vector<Artist> invalidExcludes;
-    string excludedArtist;
+bool SixDegrees::isExclude(const string &command) {
+    return command.size() > 8 and command.compare(0, 8, "exclude ") == 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: exclude
+ * @purpose: reads the artists that follow "exclude name" (ended by a "*"
+ *           line) and keeps them as the exclusion set called name, which
+ *           later queries such as "bfs name" avoid
+ *
+ * @preconditions: the graph is frozen, and no query is running
+ * @postconditions: the set replaces any earlier set with the same name
+ *
+ * @parameters: the command, where to read its lines from and where to
+ *              print errors
+ *
+ * @notes: the set is a bitmap over the artists' ids, so it is looked up
+ *         once here rather than by every query that names it. Artists not
+ *         in the dataset are reported, as not reports them, and left out
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::exclude(const string &command, istream &input,
+                         ResultWriter &output) {
+    vector<string> names;
+    size_t count = 0;
+    readNames(input, names, count);
     
-    // Mark Artists to exclude as seen, to avoid them during traversal
-    while (getline(input, excludedArtist) and excludedArtist != "*") {
-        // Cannot access invalid vertices, so we add them to a list of invalids
-        if (not CG.is_vertex(excludedArtist)) {
-            invalidExcludes.push_back(excludedArtist);
+    vector<uint64_t> bitmap((CG.vertex_count() + 63) / 64, 0);
+    for (size_t i = 0; i < count; i++) {
+        CollabGraph::VertexId id = CG.get_vertex_id(names[i]);
+        if (id == CollabGraph::NO_VERTEX) {
+            output.notFound(names[i]);
         }
         else {
-            CG.mark_vertex(excludedArtist);
+            bitmap[id / 64] |= (uint64_t) 1 << (id % 64);
         }
     }
-    // Now that all not specific processes are done, call BFS
-    bfsWrapper(a1, a2, output);
+    exclusionSets[command.substr(8)].swap(bitmap);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: isDistances
+ * @purpose: determines whether a command counts distances
+ *
+ * @preconditions: none
+ * @postconditions: none
+ *
+ * @parameters: the command
+ * @returns: true iff the command is distances or distances-sample
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool SixDegrees::isDistances(const string &command) {
+    return command == "distances" or command == "distances-sample";
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: distances
+ * @purpose: reads the input line that follows a distances command and
+ *           answers it
+ *
+ * @preconditions: the graph is frozen
+ * @postconditions: the distance counts are printed
+ *
+ * @parameters: the command, where to read input from and where to print
+ *              output to
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::distances(const string &command, istream &input, 
+                           ostream &output) {
+    string line;
+    getline(input, line);
     
-    // If there were invalid Artists print error messages, and stop function
-    if (not invalidExcludes.empty()) {
-        for (size_t i = 0; i < invalidExcludes.size(); i++) {
-            errorMessage(invalidExcludes.at(i), output);
-        }
+    if (command == "distances") {
+        distancesFrom(line, output);
+    }
+    else {
+        sampleDistances(line, output);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: distancesFrom
+ * @purpose: prints how many artists are each number of hops from one
+ *           artist, and that artist's eccentricity
+ *
+ * @preconditions: the graph is frozen
+ * @postconditions: the counts are printed, or an error message if the
+ *                  artist is not in the graph
+ *
+ * @parameters: the artist's name and where to print output to
+ *
+ * @notes: the search itself is split across numThreads threads
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::distancesFrom(const string &name, ostream &output) {
+    CollabGraph::VertexId source = CG.get_vertex_id(name);
+    if (source == CollabGraph::NO_VERTEX) {
+        output << "\"" << name << "\" was not found in the dataset :(\n";
         return;
     }
+    
+    vector<uint64_t> counts;
+    size_t eccentricity = engine.countDistances(source, counts, numThreads);
+    
+    uint64_t reached = 0;
+    for (size_t d = 0; d < counts.size(); d++) {
+        reached += counts[d];
+    }
+    
+    output << "Distances from \"" << name << "\":\n";
+    printCounts(counts, output);
+    output << "Reached " << reached << " of " << CG.vertex_count() 
+           << " artists. Eccentricity: " << eccentricity << ".\n";
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: dfsWrapper
- * @purpose: checks if Artists to traverse between are valid
+ * @function: sampleDistances
+ * @purpose: prints how many (source, artist) pairs are each number of hops
+ *           apart, over a sample of source artists, with the mean distance
+ *           and the range of the sources' eccentricities
  *
- * @preconditions: none
- * @postconditions: error message is printed or traversal begins
+ * @preconditions: the graph is frozen
+ * @postconditions: the counts are printed, or an error message if the
+ *                  number of sources is not a positive number
+ *
+ * @parameters: the number of sources, as read, and where to print output
  *
- * @parameters: Artists provided by input and where to print error message to
+ * @notes: the sources are spread evenly over the vertex ids, so a sample
+ *         is the same every time; asking for at least as many sources as
+ *         there are artists counts every pair. The sources are shared out
+ *         among numThreads engines, each searching with one thread
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::dfsWrapper(const Artist& a1, const Artist& a2, 
-                            ostream &output) {
-    // Check if Artists are vertices in the graph
-    if (not validArtists(a1, a2, output)) {
+void SixDegrees::sampleDistances(const string &number, ostream &output) {
+    char *end;
+    size_t numSources = strtoull(number.c_str(), &end, 10);
+    if (number.empty() or *end != '\0' or numSources == 0) {
+        output << number << " is not a number of artists. Please try again.\n";
         return;
     }
     
-    // If conditions are good, call the traversal function
-    dfs(a1, a2);
+    size_t numVertices = CG.vertex_count();
+    numSources = min(numSources, numVertices);
+    
+    addWorkers();
+    
+    vector<vector<uint64_t>> counts(numThreads);
+    vector<size_t> least(numThreads, SIZE_MAX), most(numThreads, 0);
+    atomic<size_t> next(0);
+    vector<thread> threads;
+    
+    for (int t = 0; t < numThreads; t++) {
+        threads.push_back(thread([&, t]() {
+            for (size_t i = next++; i < numSources; i = next++) {
+                CollabGraph::VertexId source = i * numVertices / numSources;
+                size_t eccentricity = 
+                    workers[t].countDistances(source, counts[t], 1);
+                least[t] = min(least[t], eccentricity);
+                most[t] = max(most[t], eccentricity);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    
+    // Combine what each thread found
+    for (int t = 1; t < numThreads; t++) {
+        if (counts[0].size() < counts[t].size()) {
+            counts[0].resize(counts[t].size(), 0);
+        }
+        for (size_t d = 0; d < counts[t].size(); d++) {
+            counts[0][d] += counts[t][d];
+        }
+        least[0] = min(least[0], least[t]);
+        most[0] = max(most[0], most[t]);
+    }
+    
+    uint64_t pairs = 0, hops = 0;
+    for (size_t d = 1; d < counts[0].size(); d++) {
+        pairs += counts[0][d];
+        hops += counts[0][d] * d;
+    }
+    char mean[32];
+    snprintf(mean, sizeof(mean), "%.2f", 
+             pairs == 0 ? 0.0 : (double) hops / pairs);
+    
+    // An empty graph has no sources to have eccentricities
+    if (numSources == 0) {
+        least[0] = 0;
+    }
+    
+    if (numSources == numVertices) {
+        output << "Distances from all " << numSources << " artists:\n";
+    }
+    else {
+        output << "Distances from " << numSources << " sampled artists:\n";
+    }
+    printCounts(counts[0], output);
+    output << "Connected pairs: " << pairs << ". Mean distance: " << mean 
+           << ". Eccentricity: " << least[0] << " to " << most[0] << ".\n";
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: dfs
- * @purpose: traverses by visiting nodes along the deepest path possible
+ * @function: printCounts
+ * @purpose: prints a distance histogram, one "distance<TAB>count" line for
+ *           every distance
  *
- * @preconditions: the Artists to traverse between are valid
- * @postconditions: predecessors for all visited nodes are set or error
- *                  message is printed
+ * @preconditions: none
+ * @postconditions: the counts are printed
  *
- * @parameters: Artists provided by input
+ * @parameters: the number of artists at each distance, and where to print
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::dfs(const Artist& a1, const Artist& a2) {
-    stack<Artist> pStack;
+void SixDegrees::printCounts(const vector<uint64_t> &counts, ostream &output) {
+    for (size_t d = 0; d < counts.size(); d++) {
+        output << d << "\t" << counts[d] << "\n";
+    }
+}
+
+// Set by SIGINT and SIGTERM, so a server closes its socket before exiting
+static volatile sig_atomic_t stopServing = 0;
+
+static void stopServer(int) {
+    stopServing = 1;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: serve
+ * @purpose: answers commands from any number of clients connected to a
+ *           Unix socket at socketPath, until SIGINT or SIGTERM
+ *
+ * @preconditions: the graph is frozen
+ * @postconditions: the socket has been removed, or the program has exited
+ *                  with an error if it could not be created
+ *
+ * @parameters: none
+ *
+ * @notes: clients send commands exactly as in a command file and read
+ *         back exactly what the command file would have printed. One
+ *         thread waits on every connection with ppoll and answers whatever
+ *         complete commands have arrived; every session's traversals go
+ *         into one batch, answered on numThreads threads like a command
+ *         file's. quit ends only its own session. Each session and each
+ *         command's latency, from the wakeup that found it, is logged to
+ *         standard error
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::serve() {
+    const size_t BATCH_SIZE = 4096;
+    
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << socketPath << " is too long for a socket path.\n";
+        exit(EXIT_FAILURE);
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    sockaddr *name = reinterpret_cast<sockaddr *>(&address);
+    
+    // A socket left behind by a server that was killed is replaced, but not
+    // one that a server is still answering on
+    struct stat info;
+    if (lstat(socketPath.c_str(), &info) == 0 and S_ISSOCK(info.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probe >= 0 and connect(probe, name, sizeof(address)) == 0;
+        close(probe);
+        if (live) {
+            cerr << socketPath << " is already being served on.\n";
+            exit(EXIT_FAILURE);
+        }
+        unlink(socketPath.c_str());
+    }
     
-    CG.mark_vertex(a1); 
-    pStack.push(a1);
-   
-   // Visit vertices until destination is reached or whole graph is traversed
-    while (not pStack.empty()) {
-        Artist next = pStack.top();
-        CG.mark_vertex(next);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 or bind(listener, name, sizeof(address)) != 0 or
+        listen(listener, SOMAXCONN) != 0) {
+        cerr << socketPath << " cannot be served on.\n";
+        exit(EXIT_FAILURE);
+    }
+    fcntl(listener, F_SETFL, O_NONBLOCK);
+    
+    // The stop signals are only let in while waiting, so one cannot arrive
+    // between checking stopServing and starting to wait
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    sigset_t stops, waiting;
+    sigemptyset(&stops);
+    sigaddset(&stops, SIGINT);
+    sigaddset(&stops, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stops, &waiting);
+    
+    cerr << "Serving " << CG.vertex_count() << " artists on " << socketPath 
+         << "\n";
+    
+    vector<Query> batch(BATCH_SIZE);
+    vector<string> results(BATCH_SIZE);
+    vector<pollfd> polled;
+    uint64_t nextId = 1;
+    bool ready = false;
+    const timespec NO_WAIT = {0, 0};
+    
+    while (not stopServing) {
+        polled.assign(1, pollfd{listener, POLLIN, 0});
+        for (const Session &session : sessions) {
+            short events = session.ended ? 0 : POLLIN;
+            if (session.sent < session.output.size()) {
+                events |= POLLOUT;
+            }
+            polled.push_back(pollfd{session.fd, events, 0});
+        }
         
-        // If we have reached the destination, nothing else is needed
-        if (next == a2) {
-            return;
+        // Commands already received are answered without waiting for more
+        if (ppoll(polled.data(), polled.size(), ready ? &NO_WAIT : nullptr,
+                  &waiting) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << socketPath << ": " << strerror(errno) << "\n";
+            break;
         }
+        Clock::time_point woke = Clock::now();
         
-        vector<Artist> neighbors = CG.get_vertex_neighbors(next);
+        for (size_t i = 1; i < polled.size(); i++) {
+            if (polled[i].revents != 0 and not sessions[i - 1].ended) {
+                receive(sessions[i - 1]);
+            }
+        }
+        if (polled[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                sessions.push_back(Session());
+                sessions.back().fd = fd;
+                sessions.back().id = nextId++;
+                cerr << "session " << sessions.back().id << " opened\n";
+            }
+        }
+        
+        ready = answerSessions(batch, results, woke);
         
-        // Update information for all unvisited neighbors
-        for (size_t i = 0; i < neighbors.size(); i++) {
-            if (not CG.is_marked(neighbors.at(i))) {
-               CG.mark_vertex(neighbors.at(i));
-               CG.set_predecessor(neighbors.at(i), next);
-               pStack.push(neighbors.at(i));
-           }
+        // Send what can be sent, and close the sessions that are done
+        size_t kept = 0;
+        for (size_t s = 0; s < sessions.size(); s++) {
+            Session &session = sessions[s];
+            if (session.sent < session.output.size()) {
+                transmit(session);
+            }
+            bool done = session.ended and session.input.empty() and
+                        session.sent == session.output.size();
+            if (session.failed or done) {
+                close(session.fd);
+                cerr << "session " << session.id << " closed\n";
+            }
+            else {
+                swap(sessions[kept++], session);
+            }
         }
-        pStack.pop();
-    }  
+        sessions.resize(kept);
+    }
+    
+    for (const Session &session : sessions) {
+        close(session.fd);
+    }
+    sessions.clear();
+    close(listener);
+    unlink(socketPath.c_str());
+    sigprocmask(SIG_SETMASK, &waiting, nullptr);
+    cerr << "Stopped serving on " << socketPath << "\n";
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: validArtists
- * @purpose: ensures that the Artists we want to use for traversal are 
- *           valid vertices
+ * @function: receive
+ * @purpose: reads what a client has sent without waiting for more
  *
- * @preconditions: none
- * @postconditions: if provided Artists are not in the graph, an error message
- *                  will print and the traversal function will not run 
+ * @preconditions: the session's socket is non-blocking
+ * @postconditions: the bytes read are added to the session's input; ended
+ *                  is set if the client has sent all it will, and failed
+ *                  if the connection broke
  *
- * @parameters: Artists provided by input and where to print error message to
+ * @parameters: the session
+ *
+ * @notes: at most 1 MB is read at a time, so that a client sending a lot
+ *         does not keep the others waiting
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-bool SixDegrees::validArtists(const Artist& a1, const Artist& a2, 
-                              ostream &output) {
-    // Print error messages for any invalid vertices
-    if (not CG.is_vertex(a1) and CG.is_vertex(a2)) {
-        errorMessage(a1, output);
-        return false;
-    } 
-    else if (not CG.is_vertex(a2) and CG.is_vertex(a1)) {
-        errorMessage(a2, output);
-        return false;
-    } 
-    else if (not CG.is_vertex(a1) and not CG.is_vertex(a2)) {
-        errorMessage(a1, output);
-        errorMessage(a2, output);
-        return false;
-    } 
-    return true;
+void SixDegrees::receive(Session &session) {
+    char buffer[65536];
+    for (int i = 0; i < 16; i++) {
+        ssize_t size = read(session.fd, buffer, sizeof(buffer));
+        if (size > 0) {
+            session.input.append(buffer, size);
+        }
+        else if (size == 0) {
+            session.ended = true;
+            return;
+        }
+        else if (errno != EINTR) {
+            session.failed = errno != EAGAIN and errno != EWOULDBLOCK;
+            return;
+        }
+    }
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: errorMessage
- * @purpose: print the appropriate error message when an Artist doesn't exist
+ * @function: transmit
+ * @purpose: sends as much of a session's output as the socket will take
+ *           without waiting
  *
- * @preconditions: none
- * @postconditions: none
+ * @preconditions: the session's socket is non-blocking
+ * @postconditions: sent counts what has been sent, and failed is set if
+ *                  the connection broke
+ *
+ * @parameters: the session
+ *
+ * @notes: the sent output is only removed once it is half of the output,
+ *         so a large output is not copied down again after every send
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void SixDegrees::transmit(Session &session) {
+    string &output = session.output;
+    while (session.sent < output.size()) {
+        ssize_t size = send(session.fd, output.data() + session.sent,
+                            output.size() - session.sent, MSG_NOSIGNAL);
+        if (size >= 0) {
+            session.sent += size;
+        }
+        else if (errno != EINTR) {
+            session.failed = errno != EAGAIN and errno != EWOULDBLOCK;
+            break;
+        }
+    }
+    if (session.sent == output.size() or session.sent > output.size() / 2) {
+        output.erase(0, session.sent);
+        session.sent = 0;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: answerSessions
+ * @purpose: answers the complete commands the sessions have received
  *
- * @parameters: an Artist provided by input and where to print error message to
+ * @preconditions: the graph is frozen
+ * @postconditions: each session's answered commands are removed from its
+ *                  input and their output added to its output, in order
+ *
+ * @parameters: the queries and results of a batch, to reuse, and when the
+ *              server woke up to find these commands
+ * @returns: true iff some session still has a complete command to answer
+ *
+ * @notes: every session's traversals, up to its first other command, are
+ *         answered as one batch. The other commands then run one at a
+ *         time, and the rest of their sessions' input waits for the next
+ *         call. A session with 16 MB of output its client has not read is
+ *         not answered until the client catches up
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::errorMessage(const Artist& artist, ostream &output) {
-    if (not CG.is_vertex(artist)) {
-        output << "\"" << artist.get_name() 
-             << "\" was not found in the dataset :(\n"; 
+bool SixDegrees::answerSessions(vector<Query> &batch, vector<string> &results,
+                                Clock::time_point woke) {
+    const size_t OUTPUT_LIMIT = 1 << 24;
+    
+    vector<size_t> owners, consumed(sessions.size(), 0);
+    vector<string> pending(sessions.size());
+    size_t count = 0;
+    string command;
+    
+    for (size_t s = 0; s < sessions.size(); s++) {
+        Session &session = sessions[s];
+        while (count < batch.size() and pending[s].empty() and
+               session.output.size() - session.sent < OUTPUT_LIMIT) {
+            size_t end = requestEnd(session.input, consumed[s], 
+                                    session.ended);
+            if (end == string::npos) {
+                break;
+            }
+            string request = session.input.substr(consumed[s], 
+                                                  end - consumed[s]);
+            consumed[s] = end;
+            
+            istringstream in(request);
+            getline(in, command);
+            if (isTraversal(command)) {
+                batch[count].command = command;
+                readQuery(in, batch[count]);
+                owners.push_back(s);
+                count++;
+            }
+            else {
+                pending[s] = request;
+            }
+        }
     }
+    
+    ostringstream log;
+    runBatch(batch, count, results);
+    long batchUs = chrono::duration_cast<chrono::microseconds>(
+                       Clock::now() - woke).count();
+    for (size_t i = 0; i < count; i++) {
+        Session &session = sessions[owners[i]];
+        session.output += results[i];
+        log << "session " << session.id << ": " << batch[i].command 
+            << " in " << batchUs << " us\n";
+    }
+    
+    for (size_t s = 0; s < sessions.size(); s++) {
+        if (pending[s].empty()) {
+            continue;
+        }
+        Session &session = sessions[s];
+        istringstream in(pending[s]);
+        getline(in, command);
+        if (command == "quit") {
+            session.ended = true;
+            session.input.clear();
+            consumed[s] = 0;
+        }
+        else {
+            ostringstream out;
+            ResultWriter writer(format, out);
+            runCommand(command, in, writer);
+            writer.flush();
+            session.output += out.str();
+        }
+        log << "session " << session.id << ": " << command << " in " 
+            << chrono::duration_cast<chrono::microseconds>(
+                   Clock::now() - woke).count() << " us\n";
+    }
+    
+    bool ready = false;
+    for (size_t s = 0; s < sessions.size(); s++) {
+        Session &session = sessions[s];
+        session.input.erase(0, consumed[s]);
+        size_t unsent = session.output.size() - session.sent;
+        ready = ready or (unsent < OUTPUT_LIMIT and
+                          requestEnd(session.input, 0, session.ended) !=
+                              string::npos);
+    }
+    cerr << log.str();
+    return ready;
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * @function: printPath
- * @purpose: prints the path between two Artists
+ * @function: requestEnd
+ * @purpose: finds where the command starting at from in a session's input
+ *           ends, following the same grammar as readQuery and update
  *
- * @preconditions: there is a valid path between the two artists
+ * @preconditions: none
  * @postconditions: none
  *
- * @parameters: Artists provided by input and where to print output to
+ * @parameters: the input, where the command starts, and whether the client
+ *              has sent all it will
+ * @returns: the position just past the command's last line, or string::npos
+ *           if not all of it has arrived
+ *
+ * @notes: once the client has sent everything, a command missing lines
+ *         ends with the input, as it would at the end of a command file
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void SixDegrees::printPath(const Artist& a1, const Artist& a2, 
-                           ostream &output) {
-    // Only get the path from valid vertices, avoid accessing invalid space
-    if (CG.is_vertex(a1) and CG.is_vertex(a2) == true) {
-        stack<Artist> path = CG.report_path(a1, a2);
-        
-        if (path.empty() or a1 == a2) { // Cannot have a path to self
-            output << "A path does not exist between \"" << a1 << "\" and \""
-                   << a2 << "\".\n";
-            return;
+size_t SixDegrees::requestEnd(const string &input, size_t from, bool ended) {
+    size_t at = from;
+    string line;
+    
+    // Reads the next whole line, or the unfinished last one once ended
+    auto nextLine = [&]() {
+        if (at >= input.size()) {
+            return false;
         }
-        
-        Artist curr = a1;
-        Artist next;
-        
-        path.pop();
-        
-        // Print each collaboration along the path
-        while (not path.empty()) {
-            next = path.top();
-            path.pop();
-            
-            output << "\"" << curr.get_name() << "\" collaborated with \"" 
-                   << next.get_name() << "\" in \"" << CG.get_edge(curr, next)
-                   << "\".\n";
-            
-            curr = next;
+        size_t newline = input.find('\n', at);
+        if (newline == string::npos and not ended) {
+            return false;
+        }
+        newline = min(newline, input.size());
+        line.assign(input, at, newline - at);
+        at = newline + 1;
+        return true;
+    };
+    
+    if (not nextLine()) {
+        return string::npos;
+    }
+    const string command = line;
+    string_view base(command.data(), min(command.find(' '), command.size()));
+    size_t lines = 0;
+    bool list = false;
+    if (command == "bfs-many" or command == "add-artist") {
+        lines = 1;
+        list = true;
+    }
+    else if (isTraversal(command) and (base == "not" or base == "binot")) {
+        lines = 2;
+        list = true;
+    }
+    else if (isExclude(command)) {
+        list = true;
+    }
+    else if (command == "incl") {
+        lines = 3;
+    }
+    else if (isTraversal(command) or command == "add-song") {
+        lines = 2;
+    }
+    else if (isDistances(command)) {
+        lines = 1;
+    }
+    
+    const size_t missing = ended ? input.size() : string::npos;
+    for (size_t i = 0; i < lines; i++) {
+        if (not nextLine()) {
+            return missing;
+        }
+    }
+    while (list) {
+        if (not nextLine()) {
+            return missing;
+        }
+        if (line == "*") {
+            break;
         }
-        output << "***\n";
     }
+    return min(at, input.size());
 }
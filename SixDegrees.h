@@ -18,8 +18,13 @@
 
 #include "Artist.h"
 #include "CollabGraph.h"
+#include "ResultWriter.h"
+#include "TraversalEngine.h"
 
-#include <queue>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
 
 using namespace std;
 
@@ -35,6 +40,14 @@ public:
     // Further handles command line arguments and feeds them to driver function
     void run();
     
+    // Populates the graph, as run does before any command, and returns it
+    // for benchmarks to time
+    CollabGraph &load();
+    
+    // Answers commands as a command file's are answered on the given
+    // number of threads (batchLoop, even on one), for benchmarks to time
+    void answerBatches(istream &input, ostream &output, int threads);
+    
 private:
     // The CollabGraph instance we want to traverse
     CollabGraph CG;
@@ -44,34 +57,92 @@ private:
     
     // Variables that make the handling of command line arguments clear
     int numFiles;
+    int numThreads = 1;
+    bool directionOptimizing = false;
+    int numLandmarks = -1;
+    ResultWriter::Format format = ResultWriter::TEXT;
     string dataFile;
     string inputFile;
     string outputFile;
+    string socketPath;
+    static bool parseCount(const char *text, int &count);
     
     // Heler functions to populate the CollabGraph
+    void buildSnapshot(const string &data, const string &snapshot);
     void importData();
-    vector<Artist> getArtists(istream &input);
+    void addLandmarks();
+    void getArtists(const char *begin, const char *end,
+                    CollabGraph::Builder &builder);
+    void getArtists(const char *begin, const char *end);
+    static bool nextRecord(const char *&at, const char *end, 
+                           string_view &name, vector<string_view> &songs);
+    static const char *recordStart(const char *begin, const char *end,
+                                   const char *from);
+    static string_view nextLine(const char *&at, const char *end);
     
     // Driver function, which executes the necessary functions when called
     void commandLoop(istream &input, ostream &output);
+    void runCommand(const string &command, istream &input, 
+                    ResultWriter &output);
+    
+    // Driver for command files when answering queries on several threads
+    void batchLoop(istream &input, ResultWriter &output);
+    void runBatch(const vector<Query> &batch, size_t count, 
+                  vector<string> &results);
+    
+    // Helper functions that gather data for the traversal functions
+    static bool isTraversal(const string &command);
+    void readQuery(istream &input, Query &query);
+    static void readNames(istream &input, vector<string> &names, 
+                          size_t &count);
+    
+    // Commands that count how far artists are from each other, which use
+    // every thread on their own
+    static bool isDistances(const string &command);
+    void distances(const string &command, istream &input, ostream &output);
+    void distancesFrom(const string &name, ostream &output);
+    void sampleDistances(const string &number, ostream &output);
+    static void printCounts(const vector<uint64_t> &counts, ostream &output);
+    
+    // Commands that add artists and songs to the graph as it runs
+    static bool isUpdate(const string &command);
+    void update(const string &command, istream &input, 
+                ResultWriter &output);
+    vector<string> songs;
     
-    // Helper function for that gathers data for the traversal functions
-    void traversalHelper(string command, istream &input, ostream &output);
+    // Named sets of artists for queries to exclude, defined by "exclude"
+    static bool isExclude(const string &command);
+    void exclude(const string &command, istream &input, 
+                 ResultWriter &output);
+    ExclusionSets exclusionSets;
     
-    // Traversal functions
-    void bfs(const Artist& a1, const Artist& a2);
-    void dfs(const Artist& a1, const Artist& a2);
-    void bfsWrapper(const Artist& a1, const Artist& a2, ostream &output);
-    void dfsWrapper(const Artist& a1, const Artist& a2, ostream &output);
-    void notWrapper(const Artist& a1, const Artist& a2, istream &input, 
-                    ostream &output);
+    // Answers traversal queries; the query is reused so it rarely allocates
+    TraversalEngine engine;
+    Query query;
     
-    // Helper functions to ensure Artist exists in the CollabGraph
-    void errorMessage(const Artist& source, ostream &output);
-    bool validArtists(const Artist& a1, const Artist& a2, ostream &output);
+    // One engine per thread for batches, kept so their buffers are reused
+    vector<TraversalEngine> workers;
+    void addWorkers();
     
-    // Helper function that prints path from traversal
-    void printPath(const Artist& source, const Artist& dest, ostream &output);
+    // Server mode: answers clients connected to a Unix socket, all sharing
+    // the one loaded graph
+    typedef chrono::steady_clock Clock;
+    struct Session {
+        int fd;
+        uint64_t id;
+        string input;           // received, not yet answered
+        string output;          // answered, not yet all sent
+        size_t sent = 0;        // how much of output has been sent
+        bool ended = false;     // the client sent all it will, or quit
+        bool failed = false;    // the connection broke
+    };
+    vector<Session> sessions;
+    void serve();
+    void receive(Session &session);
+    void transmit(Session &session);
+    bool answerSessions(vector<Query> &batch, vector<string> &results,
+                        Clock::time_point woke);
+    static size_t requestEnd(const string &input, size_t from, bool ended);
 };
 
 #endif /* _SIX_DEGREES_H_ */
\ No newline at end of file
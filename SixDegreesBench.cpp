@@ -0,0 +1,196 @@
+/*
+ * SixDegreesBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Times each stage of SixDegrees on one data file, such as one written by
+ * GraphGen, and prints the results as one line of JSON, so runs can be
+ * compared between releases. The stages are timed separately:
+ *   1) loading the data file, exactly as SixDegrees does
+ *   2) clear_metadata
+ *   3) the same random bfs, dfs and not queries (not excludes every other
+ *      collaborator of the source)
+ *   4) print_graph, on the same number of threads
+ * Output is written to a stream that only counts its bytes, so printing
+ * is timed without storing it.
+ *
+ * Usage: SixDegreesBench [--threads N] dataFile [queries] [seed]
+ *
+ */
+
+#include "CollabGraph.h"
+#include "SixDegrees.h"
+#include "TraversalEngine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// A stream buffer that discards its output, counting its bytes
+class CountingBuffer : public streambuf {
+public:
+    uint64_t bytes = 0;
+
+protected:
+    int overflow(int c) override {
+        bytes++;
+        return c;
+    }
+    streamsize xsputn(const char *, streamsize count) override {
+        bytes += count;
+        return count;
+    }
+};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: jsonString
+ * @purpose: quotes a string for JSON
+ *
+ * @parameters: the string
+ * @returns: the string in quotes, with quotes, backslashes and control
+ *           characters escaped
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static string jsonString(const string &text) {
+    const char *HEX = "0123456789abcdef";
+    string quoted = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' or c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if (c < 0x20) {
+            quoted += "\\u00";
+            quoted += HEX[c >> 4];
+            quoted += HEX[c & 15];
+        }
+        else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: answer
+ * @purpose: answers every query with one command, timing them all
+ *
+ * @parameters: the engine, the command, the queries and where to count
+ *              their output
+ * @returns: the mean time per query in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double answer(TraversalEngine &engine, const string &command,
+                     vector<Query> &queries, ostream &output) {
+    Clock::time_point start = Clock::now();
+    for (Query &query : queries) {
+        query.command = command;
+        engine.run(query, output);
+    }
+    return milliseconds(start) / queries.size();
+}
+
+int main(int argc, char *argv[]) {
+    // "--threads N" is passed on to SixDegrees, which loads on N threads
+    int first = 1, numThreads = 1;
+    vector<char *> options = {argv[0]};
+    if (argc > 2 and string(argv[1]) == "--threads") {
+        options.push_back(argv[1]);
+        options.push_back(argv[2]);
+        numThreads = atoi(argv[2]);
+        first = 3;
+    }
+
+    if (argc <= first or argc > first + 3) {
+        cerr << "Usage: SixDegreesBench [--threads N] dataFile [queries]"
+             << " [seed]\n";
+        return EXIT_FAILURE;
+    }
+    string dataFile = argv[first];
+    size_t numQueries = argc > first + 1 ? atol(argv[first + 1]) : 200;
+    unsigned seed     = argc > first + 2 ? atol(argv[first + 2]) : 15;
+    options.push_back(argv[first]);
+
+    SixDegrees program(options.size(), options.data());
+    Clock::time_point start = Clock::now();
+    CollabGraph &graph = program.load();
+    double loadMs = milliseconds(start);
+
+    size_t numArtists = graph.vertex_count();
+    if (numArtists == 0 or numQueries == 0) {
+        cerr << dataFile << " has no artists to query.\n";
+        return EXIT_FAILURE;
+    }
+
+    // One clear is far too quick to time on its own
+    const size_t CLEARS = 1000;
+    start = Clock::now();
+    for (size_t i = 0; i < CLEARS; i++) {
+        graph.clear_metadata();
+    }
+    double clearNs = milliseconds(start) * 1e6 / CLEARS;
+
+    // A different generator than GraphGen's, so the same seed does not pick
+    // the artists GraphGen picked as collaborators
+    mt19937_64 random(seed);
+    vector<Query> queries(numQueries);
+    for (Query &query : queries) {
+        CollabGraph::VertexId source = random() % numArtists;
+        query.source = string(graph.get_vertex_name(source));
+        query.dest   = string(graph.get_vertex_name(random() % numArtists));
+        const CollabGraph::VertexId *neighbor = graph.neighbors_begin(source);
+        for (; neighbor < graph.neighbors_end(source); neighbor += 2) {
+            query.excluded.push_back(string(graph.get_vertex_name(*neighbor)));
+        }
+        query.numExcluded = query.excluded.size();
+    }
+
+    TraversalEngine engine(graph);
+    CountingBuffer counted;
+    ostream output(&counted);
+    double bfsMs = answer(engine, "bfs", queries, output);
+    double dfsMs = answer(engine, "dfs", queries, output);
+    double notMs = answer(engine, "not", queries, output);
+    uint64_t queryBytes = counted.bytes;
+
+    counted.bytes = 0;
+    start = Clock::now();
+    graph.print_graph(output, numThreads);
+    double printMs = milliseconds(start);
+
+    cout << "{\"data\": " << jsonString(dataFile)
+         << ", \"artists\": " << numArtists
+         << ", \"collaborations\": " << graph.adjacency_size() / 2
+         << ", \"threads\": " << numThreads
+         << ", \"queries\": " << numQueries
+         << ", \"load_ms\": " << loadMs
+         << ", \"clear_metadata_ns\": " << clearNs
+         << ", \"bfs_ms\": " << bfsMs
+         << ", \"dfs_ms\": " << dfsMs
+         << ", \"not_ms\": " << notMs
+         << ", \"query_output_bytes\": " << queryBytes
+         << ", \"print_graph_ms\": " << printMs
+         << ", \"print_graph_bytes\": " << counted.bytes
+         << ", \"memory_bytes\": " << graph.memory_footprint() << "}\n";
+
+    return EXIT_SUCCESS;
+}
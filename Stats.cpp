@@ -0,0 +1,233 @@
+/*
+ * Stats.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Implementation of the Stats instrumentation. Each thread keeps its own
+ * counts and phase times, so counting never contends, and adds them to
+ * the shared totals when it flushes: at the start and end of every query,
+ * when a helper thread finishes, and when the totals are printed. With
+ * SIXDEGREES_STATS defined, operator new (aligned or not) is also replaced
+ * here to count allocations.
+ *
+ */
+
+#include "Stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#ifdef SIXDEGREES_STATS
+
+thread_local uint64_t Stats::counts[Stats::NUM_COUNTERS];
+thread_local uint64_t Stats::nanoseconds[Stats::NUM_PHASES];
+thread_local Stats::Phase Stats::current = Stats::NO_PHASE;
+thread_local Stats::Clock::time_point Stats::since;
+
+// The totals of every thread that has flushed
+static atomic<uint64_t> queryCounts[Stats::NUM_COUNTERS];
+static atomic<uint64_t> otherCounts[Stats::NUM_COUNTERS];
+static atomic<uint64_t> phaseNanoseconds[Stats::NUM_PHASES];
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: switchTo
+ * @purpose: credits the time since the last switch to the current phase,
+ *           and makes another phase current
+ *
+ * @preconditions: none
+ * @postconditions: phase is this thread's current phase
+ *
+ * @parameters: the phase to switch to
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void Stats::switchTo(Phase phase) {
+    Clock::time_point now = Clock::now();
+    nanoseconds[current] += chrono::duration_cast<chrono::nanoseconds>(
+                                now - since).count();
+    since = now;
+    current = phase;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: Timer constructor and destructor
+ * @purpose: make a phase current for as long as the timer is alive
+ *
+ * @preconditions: timers on one thread end in the reverse order they
+ *                 started, as scoped objects do
+ * @postconditions: the phase before the timer is current again once it
+ *                  ends
+ *
+ * @parameters: the phase to time
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+Stats::Timer::Timer(Phase phase) : previous(current) {
+    switchTo(phase);
+}
+
+Stats::Timer::~Timer() {
+    switchTo(previous);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: QueryTimer constructor and destructor
+ * @purpose: time one query as TRAVERSE, and keep what it counts apart
+ *
+ * @preconditions: as for Timer
+ * @postconditions: the counts from before the query are flushed as
+ *                  outside queries, and the query's own counts, with one
+ *                  more query, as in queries
+ *
+ * @parameters: none
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+Stats::QueryTimer::QueryTimer() : previous(current) {
+    flush(false);
+    switchTo(TRAVERSE);
+}
+
+Stats::QueryTimer::~QueryTimer() {
+    switchTo(previous);
+    counts[QUERIES]++;
+    flush(true);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: flush
+ * @purpose: adds this thread's counts and phase times to the totals
+ *
+ * @preconditions: none
+ * @postconditions: this thread's counts and times are zero, and the
+ *                  current phase has been credited up to now
+ *
+ * @parameters: whether the counts were made by a query
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void Stats::flush(bool query) {
+    switchTo(current);
+    atomic<uint64_t> *totals = query ? queryCounts : otherCounts;
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        totals[c] += counts[c];
+        counts[c] = 0;
+    }
+    for (int p = 0; p < NUM_PHASES; p++) {
+        phaseNanoseconds[p] += nanoseconds[p];
+        nanoseconds[p] = 0;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: total
+ * @purpose: reads one counter without printing every one
+ *
+ * @preconditions: none
+ * @postconditions: none
+ *
+ * @parameters: the counter
+ * @returns: its count in and outside queries, this thread's included
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t Stats::total(Counter counter) {
+    return queryCounts[counter] + otherCounts[counter] + counts[counter];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: operator new and operator delete
+ * @purpose: allocate with malloc like the standard ones, counting every
+ *           allocation
+ *
+ * @notes: the array, nothrow and sized forms all end up here. The aligned
+ *         forms are replaced too, since std::pmr::new_delete_resource, and
+ *         so every arena, allocates its blocks with them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void *operator new(size_t size) {
+    Stats::count(Stats::ALLOCATIONS, 1);
+    void *memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+void *operator new(size_t size, align_val_t alignment) {
+    Stats::count(Stats::ALLOCATIONS, 1);
+    size_t bytes = static_cast<size_t>(alignment);
+    void *memory = nullptr;
+    if (posix_memalign(&memory, bytes < sizeof(void *) ? sizeof(void *) : bytes,
+                       size == 0 ? 1 : size) != 0) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new(size_t size, align_val_t alignment,
+                   const nothrow_t &) noexcept {
+    try {
+        return operator new(size, alignment);
+    }
+    catch (const bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *memory, align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t, align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, align_val_t, const nothrow_t &) noexcept {
+    free(memory);
+}
+
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: print
+ * @purpose: prints the time spent in each phase, and each counter in
+ *           queries, per query and outside queries, one tab-separated row
+ *           each
+ *
+ * @preconditions: none
+ * @postconditions: the totals so far are printed, including this thread's
+ *
+ * @parameters: where to print them
+ *
+ * @notes: a phase's time is summed over the threads that ran it, so
+ *         queries answered on several threads can add up to more than the
+ *         time that passed. Without SIXDEGREES_STATS, only says how to
+ *         build with it
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void Stats::print(ostream &output) {
+#ifdef SIXDEGREES_STATS
+    const char *PHASES[] = {"none", "parse", "build", "clear metadata",
+                            "traverse", "output", "update"};
+    const char *COUNTERS[] = {"queries", "vertices visited", "edges scanned",
+                              "hash lookups", "allocations"};
+
+    flush(false);
+    output << "phase\tms\n";
+    for (int p = PARSE; p < NUM_PHASES; p++) {
+        output << PHASES[p] << "\t" << phaseNanoseconds[p] / 1e6 << "\n";
+    }
+
+    uint64_t queries = queryCounts[QUERIES];
+    output << "counter\tin queries\tper query\toutside queries\n";
+    for (int c = QUERIES; c < NUM_COUNTERS; c++) {
+        double perQuery = queries == 0 ? 0 : (double) queryCounts[c] / queries;
+        output << COUNTERS[c] << "\t" << queryCounts[c] << "\t" << perQuery
+               << "\t" << otherCounts[c] << "\n";
+    }
+#else
+    output << "stats needs a build with \"make STATS=1\".\n";
+#endif
+}
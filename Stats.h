@@ -0,0 +1,110 @@
+/*
+ * Stats.h
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Opt-in instrumentation for SixDegrees and CollabGraph: how long each
+ * phase of the program took, and counters of the work queries do, printed
+ * by the stats command. It is only compiled in when SIXDEGREES_STATS is
+ * defined ("make STATS=1"); otherwise every STATS_ macro expands to
+ * nothing, so the traversals cost exactly what they did before.
+ *
+ */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+class Stats {
+
+public:
+    // What the program is doing. Time inside a nested timer only counts
+    // toward the nested timer's phase
+    enum Phase {
+        NO_PHASE,
+        PARSE,
+        BUILD,
+        CLEAR,
+        TRAVERSE,
+        OUTPUT,
+        UPDATE,
+        NUM_PHASES
+    };
+
+    // Work counted on every thread, and split by whether a query did it
+    enum Counter {
+        QUERIES,
+        VERTICES_VISITED,
+        EDGES_SCANNED,
+        HASH_LOOKUPS,
+        ALLOCATIONS,
+        NUM_COUNTERS
+    };
+
+    // Prints every phase's time and every counter (or that they were not
+    // compiled in)
+    static void print(std::ostream &output);
+
+#ifdef SIXDEGREES_STATS
+    // Credits the time it is alive to a phase
+    class Timer {
+    public:
+        Timer(Phase phase);
+        ~Timer();
+
+    private:
+        Phase previous;
+    };
+
+    // A Timer for TRAVERSE whose counts are kept apart as one query's
+    class QueryTimer {
+    public:
+        QueryTimer();
+        ~QueryTimer();
+
+    private:
+        Phase previous;
+    };
+
+    static void count(Counter counter, uint64_t amount) {
+        counts[counter] += amount;
+    }
+
+    // Adds this thread's counts and times to the totals print reports
+    static void flush(bool query);
+
+    // A counter's total so far, in queries and outside them, including
+    // this thread's unflushed count
+    static uint64_t total(Counter counter);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // Each thread counts on its own and adds to the totals when it flushes
+    static thread_local uint64_t counts[NUM_COUNTERS];
+    static thread_local uint64_t nanoseconds[NUM_PHASES];
+    static thread_local Phase current;
+    static thread_local Clock::time_point since;
+
+    static void switchTo(Phase phase);
+#endif
+};
+
+#ifdef SIXDEGREES_STATS
+#define STATS_TIMER(phase)           Stats::Timer statsTimer(Stats::phase)
+#define STATS_QUERY()                Stats::QueryTimer statsQuery
+#define STATS_COUNT(counter, amount) Stats::count(Stats::counter, amount)
+#define STATS_FLUSH()                Stats::flush(false)
+#else
+#define STATS_TIMER(phase)
+#define STATS_QUERY()
+#define STATS_COUNT(counter, amount)
+#define STATS_FLUSH()
+#endif
+
+#endif /* _STATS_H_ */
@@ -0,0 +1,133 @@
+/*
+ * ThreadBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Measures how answering a command file scales with threads. On one data
+ * file, such as one written by GraphGen, a command file of bfs queries
+ * between random pairs of different artists is answered the way
+ * "SixDegrees --threads N" answers it, in batches, for 1, 2, 4 ... threads
+ * up to the given number, which is also tried if it is not a power of two.
+ * For each number of threads it prints the queries answered per second and
+ * the speedup over one thread, and checks the output is the same as one
+ * thread's.
+ *
+ * Usage: ThreadBench dataFile [maxThreads] [queries] [seed]
+ *
+ */
+
+#include "CollabGraph.h"
+#include "SixDegrees.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: threadCounts
+ * @purpose: lists the numbers of threads to time
+ *
+ * @parameters: the most threads to time
+ * @returns: 1, 2, 4 ... up to maxThreads, then maxThreads itself
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static vector<int> threadCounts(int maxThreads) {
+    vector<int> counts;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    if (counts.back() != maxThreads) {
+        counts.push_back(maxThreads);
+    }
+    return counts;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 or argc > 5) {
+        cerr << "Usage: ThreadBench dataFile [maxThreads] [queries] [seed]\n";
+        return EXIT_FAILURE;
+    }
+    int maxThreads    = argc > 2 ? atol(argv[2])
+                                 : max(1u, thread::hardware_concurrency());
+    size_t numQueries = argc > 3 ? atol(argv[3]) : 2000;
+    unsigned seed     = argc > 4 ? atol(argv[4]) : 15;
+    if (maxThreads < 1) {
+        cerr << "maxThreads must be at least 1.\n";
+        return EXIT_FAILURE;
+    }
+
+    SixDegrees program(2, argv);
+    CollabGraph &graph = program.load();
+
+    size_t numArtists = graph.vertex_count();
+    if (numArtists < 2 or numQueries == 0) {
+        cerr << argv[1] << " does not have two artists to query.\n";
+        return EXIT_FAILURE;
+    }
+
+    // Every number of threads answers the same command file
+    mt19937_64 random(seed);
+    string commands;
+    for (size_t q = 0; q < numQueries; q++) {
+        CollabGraph::VertexId source = random() % numArtists;
+        CollabGraph::VertexId dest   = random() % numArtists;
+        while (dest == source) {
+            dest = random() % numArtists;
+        }
+        commands += "bfs\n";
+        commands += graph.get_vertex_name(source);
+        commands += "\n";
+        commands += graph.get_vertex_name(dest);
+        commands += "\n";
+    }
+
+    cout << "graph: " << numArtists << " artists, "
+         << graph.adjacency_size() / 2 << " collaborations, " << numQueries
+         << " queries, " << thread::hardware_concurrency() << " cores\n";
+
+    bool same = true;
+    string expected;
+    double oneThreadRate = 0;
+    for (int threads : threadCounts(maxThreads)) {
+        istringstream input(commands);
+        ostringstream output;
+
+        Clock::time_point start = Clock::now();
+        program.answerBatches(input, output, threads);
+        double rate = numQueries / (milliseconds(start) / 1000);
+
+        if (threads == 1) {
+            expected = output.str();
+            oneThreadRate = rate;
+        }
+        same = same and output.str() == expected;
+
+        cout << threads << (threads == 1 ? " thread:  " : " threads: ")
+             << rate << " queries/s, " << rate / oneThreadRate
+             << "x one thread\n";
+    }
+    cout << "same output: " << (same ? "yes" : "no") << "\n";
+
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
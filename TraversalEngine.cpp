@@ -0,0 +1,1374 @@
+/*
+ * TraversalEngine.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Implementation for the TraversalEngine interface. A TraversalEngine runs
+ * the traversal commands against a frozen CollabGraph, keeping every piece
+ * of per-query state to itself so that the graph is only ever read.
+ *
+ */
+
+#include "CollabGraph.h"
+#include "ResultWriter.h"
+#include "Stats.h"
+#include "TraversalEngine.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+// Depth of a vertex countDistances has not reached
+static const uint32_t UNREACHED = UINT32_MAX;
+
+// A level is searched bottom-up once its vertices have more than 1/ALPHA of
+// the unexplored edges, and top-down again once the levels are shrinking and
+// it holds fewer than 1/BETA of the vertices (the thresholds of Beamer et
+// al.'s direction-optimizing breadth first search)
+static const uint64_t ALPHA = 14;
+static const uint64_t BETA = 24;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: searchBottomUp
+ * @purpose: decides whether the next level of a direction-optimizing
+ *           search should be found bottom-up
+ *
+ * @preconditions: none
+ * @postconditions: none
+ *
+ * @parameters: whether the last level was found bottom-up, the number of
+ *              edges of the frontier and of the still unexplored vertices,
+ *              the size of the frontier and of the level before it, and
+ *              the number of vertices in the graph
+ * @returns: true iff the next level should be found bottom-up
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static bool searchBottomUp(bool bottomUp, uint64_t frontierEdges, 
+                           uint64_t unexplored, size_t frontierSize,
+                           size_t previous, size_t numVertices) {
+    if (not bottomUp) {
+        return frontierEdges > unexplored / ALPHA;
+    }
+    return not (frontierSize < previous and 
+                frontierSize < numVertices / BETA);
+}
+
+// Vertices handed to a thread at a time when a level is split up
+static const size_t CHUNK = 4096;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: runTasks
+ * @purpose: runs task(thread, 0) .. task(thread, numTasks - 1) on up to
+ *           numThreads threads, each taking the next unstarted task
+ *
+ * @preconditions: none
+ * @postconditions: every task has finished
+ *
+ * @parameters: how many threads to use, how many tasks there are, and the
+ *              task to run
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void runTasks(unsigned numThreads, size_t numTasks,
+                     const function<void(unsigned, size_t)> &task) {
+    // Small levels are not worth starting threads for
+    if (numThreads <= 1 or numTasks <= 1) {
+        for (size_t i = 0; i < numTasks; i++) {
+            task(0, i);
+        }
+        return;
+    }
+    
+    atomic<size_t> next(0);
+    vector<thread> threads;
+    for (unsigned t = 0; t < numThreads; t++) {
+        threads.push_back(thread([&, t]() {
+            for (size_t i = next++; i < numTasks; i = next++) {
+                task(t, i);
+            }
+            STATS_FLUSH();
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructor
+ * @purpose: initialize a TraversalEngine instance
+ *
+ * @preconditions: none
+ * @postconditions: the engine answers queries on the given graph
+ *
+ * @parameters: the graph to search, which should be frozen before any
+ *              query is run and must outlive the engine
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+TraversalEngine::TraversalEngine(const CollabGraph &graph) 
+    : CG(graph), buffered(ResultWriter::TEXT) {
+
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: setDirectionOptimizing
+ * @purpose: chooses the search behind the bfs and not commands
+ *
+ * @preconditions: none
+ * @postconditions: bfs and not use directionOptimizingBfs if use is true,
+ *                  and the classic queue-based bfs otherwise
+ *
+ * @parameters: whether to use the direction-optimizing search
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::setDirectionOptimizing(bool use) {
+    directionOptimizing = use;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: setExclusionSets
+ * @purpose: gives the engine the exclusion sets that bfs, dfs, not, bibfs
+ *           and binot queries can name
+ *
+ * @preconditions: the sets outlive the engine, and are not changed while
+ *                 it answers a query
+ * @postconditions: a query naming a set avoids its artists
+ *
+ * @parameters: the sets
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::setExclusionSets(const ExclusionSets *sets) {
+    exclusionSets = sets;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: run
+ * @purpose: answers one bfs, dfs, not, bibfs, binot, bfs-many, incl or
+ *           degrees query
+ *
+ * @preconditions: the graph is frozen
+ * @postconditions: the result of the query is printed
+ *
+ * @parameters: the query to answer and where to print output to
+ *
+ * @notes: both artists are looked up once here, and everything after works
+ *         on their VertexIds. The frontier and path buffers keep their
+ *         capacity, so once they have grown a query does no heap allocation
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::run(const Query &query, ResultWriter &output) {
+    STATS_QUERY();
+    
+    if (query.command == "bfs-many") {
+        bfsMany(query, output);
+        return;
+    }
+    
+    VertexId source = CG.get_vertex_id(query.source);
+    VertexId dest   = CG.get_vertex_id(query.dest);
+    
+    // degrees only reads the landmark distances, so needs no search state
+    if (query.command == "degrees") {
+        degrees(source, dest, query, output);
+        return;
+    }
+    
+    state.clear(CG.vertex_count());
+    
+    // incl prints its own path, which can pass through an Artist twice
+    if (query.command == "incl") {
+        inclWrapper(source, dest, query, output);
+        return;
+    }
+    
+    // A named exclusion set is marked all at once, by its bitmap
+    if (not query.exclusionSet.empty()) {
+        if (exclusionSets == nullptr or 
+            exclusionSets->count(query.exclusionSet) == 0) {
+            output.message("There is no exclusion set called \"" + 
+                           query.exclusionSet + "\".");
+            return;
+        }
+        state.exclude(exclusionSets->at(query.exclusionSet).data());
+    }
+    
+    // bibfs and binot are bfs and not, searching from both ends at once
+    const string &command = query.command;
+    bidirectional = (command == "bibfs" or command == "binot");
+    frontier.clear();
+    backFrontier.clear();
+    
+    // Call the appropriate function based on input
+    if (command == "bfs" or command == "bibfs") {
+        bfsWrapper(source, dest, query, output);
+    }
+    else if (command == "dfs") {
+        dfsWrapper(source, dest, query, output);
+    }
+    else {
+        notWrapper(source, dest, query, output);
+    }
+    // Print the result
+    printPath(source, dest, query, output);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: run
+ * @purpose: answers one query, printing its result as text to a stream
+ *
+ * @preconditions: the graph is frozen
+ * @postconditions: the result of the query is printed
+ *
+ * @parameters: the query to answer and where to print output to
+ *
+ * @notes: the result is formatted in the engine's own writer and written
+ *         to the stream at once
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::run(const Query &query, ostream &output) {
+    buffered.clear();
+    run(query, buffered);
+    output.write(buffered.text().data(), buffered.text().size());
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: verticesReached
+ * @purpose: reports how much of the graph the last search reached
+ *
+ * @preconditions: the last query was a bfs, not, bibfs or binot answered
+ *                 by bfs or bidirectionalBfs
+ * @postconditions: none
+ *
+ * @parameters: none
+ * @returns: the number of artists in the forward and backward queues,
+ *           which is 0 if the query never searched
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t TraversalEngine::verticesReached() const {
+    return frontier.size() + backFrontier.size();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: bfsWrapper
+ * @purpose: checks if Artists to traverse between are valid, and if either of
+ *           them were excluded from the not function/visited already
+ *
+ * @preconditions: none
+ * @postconditions: error messages are printed or traversal begins
+ *
+ * @parameters: ids of the Artists provided by input (NO_VERTEX if not in
+ *              the graph), the query, and where to print error message to
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::bfsWrapper(VertexId source, VertexId dest, 
+                                 const Query &query, ResultWriter &output) {
+    // Check if Artists are vertices in the graph
+    if (not validArtists(source, dest, query, output)) {
+        return;
+    }
+    
+    // If either of the Artists are excluded by the not function, stop 
+    else if (state.is_marked(source) or state.is_marked(dest)) {
+        return;
+    }
+    
+    // A landmark that reaches only one of the Artists proves there is no
+    // path, without searching
+    uint32_t lower, upper;
+    if (not CG.distance_bounds(source, dest, lower, upper)) {
+        return;
+    }
+    
+    // If conditions are good, call the traversal function. Excluded
+    // Artists can make the path longer than the landmarks' upper bound, so
+    // only a query without any is guided by it
+    if (bidirectional) {
+        bidirectionalBfs(source, dest);
+    }
+    else if (directionOptimizing) {
+        directionOptimizingBfs(source, dest);
+    }
+    else if (upper != CollabGraph::NO_BOUND and query.numExcluded == 0 and
+             query.exclusionSet.empty()) {
+        landmarkBfs(source, dest, upper);
+    }
+    else {
+        bfs(source, dest);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: bfsMany
+ * @purpose: answers a bfs query from one source to every target of a
+ *           bfs-many with a single traversal
+ *
+ * @preconditions: none
+ * @postconditions: for each target, in order, exactly what "bfs" from the
+ *                  source to that target would print is printed
+ *
+ * @parameters: the query holding the source and targets, and where to print
+ *              output to
+ *
+ * @notes: a bfs that stops at its destination has already set every
+ *         predecessor on the destination's path, and going on never changes
+ *         a predecessor, so one search of the whole component gives the same
+ *         path to every target as a search for each one
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::bfsMany(const Query &query, ResultWriter &output) {
+    state.clear(CG.vertex_count());
+    bidirectional = false;
+    
+    VertexId source = CG.get_vertex_id(query.source);
+    if (source != CollabGraph::NO_VERTEX) {
+        bfs(source, CollabGraph::NO_VERTEX);
+    }
+    
+    // Answer each target as its own bfs query would
+    single.command = "bfs";
+    single.source = query.source;
+    for (size_t i = 0; i < query.numTargets; i++) {
+        single.dest = query.targets[i];
+        VertexId dest = CG.get_vertex_id(single.dest);
+        
+        validArtists(source, dest, single, output);
+        printPath(source, dest, single, output);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: bfs
+ * @purpose: traverses by repeatedly visiting all neighbors of a node
+ *
+ * @preconditions: the Artists to traverse between are valid
+ * @postconditions: predecessors for all visited nodes are set or error
+ *                  message is printed
+ *
+ * @parameters: ids of the Artists provided by input
+ *
+ * @notes: the frontier vector is used as the queue; 'head' is its front
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::bfs(VertexId source, VertexId dest) {
+    frontier.clear();
+    
+    state.mark_vertex(source);
+    frontier.push_back(source);
+    
+    // Visit vertices until destination is reached or whole graph is traversed
+    for (size_t head = 0; head < frontier.size(); head++) {
+        VertexId next = frontier[head];
+        
+        // If we have reached the destination, nothing else is needed
+        if (next == dest) {
+            return;
+        }
+        
+        // Update information for all unvisited neighbors
+        const VertexId *end = CG.neighbors_end(next);
+        STATS_COUNT(VERTICES_VISITED, 1);
+        STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(next));
+        for (const VertexId *n = CG.neighbors_begin(next); n != end; n++) {
+            if (not state.is_marked(*n)) {
+                state.mark_vertex(*n);
+                state.set_predecessor(*n, next);
+                frontier.push_back(*n);
+            }
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: landmarkBfs
+ * @purpose: traverses like bfs, but only as deep as the landmarks' upper
+ *           bound allows, and stops as soon as the destination is found
+ *
+ * @preconditions: the Artists to traverse between are valid, nothing is
+ *                 excluded, and the landmarks put the destination at most
+ *                 limit hops from the source
+ * @postconditions: the predecessors from the source to the destination are
+ *                  exactly the ones bfs would set
+ *
+ * @parameters: ids of the Artists provided by input, and the landmarks'
+ *              upper bound on the distance between them
+ *
+ * @notes: 1) bfs goes on expanding its queue until the destination reaches
+ *            the front, but the destination's predecessor is fixed as soon
+ *            as it is found, so stopping there gives the same path
+ *         2) once the search is limit - 1 hops deep, the destination must be
+ *            among the next vertices found, so none of them are queued
+ *         3) the landmarks could also drop every vertex whose lower bound
+ *            puts it too far from the destination, but on collaboration
+ *            graphs those bounds are too loose to pay for checking them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::landmarkBfs(VertexId source, VertexId dest, 
+                                  uint32_t limit) {
+    frontier.clear();
+    
+    state.mark_vertex(source);
+    frontier.push_back(source);
+    
+    // Vertices before levelEnd in the queue are depth - 1 hops from the
+    // source, so the vertices they find are depth hops from it
+    uint32_t depth = 1;
+    size_t levelEnd = 1;
+    
+    for (size_t head = 0; head < frontier.size(); head++) {
+        if (head == levelEnd) {
+            depth++;
+            levelEnd = frontier.size();
+        }
+        
+        VertexId next = frontier[head];
+        if (next == dest) {
+            return;
+        }
+        
+        const VertexId *end = CG.neighbors_end(next);
+        STATS_COUNT(VERTICES_VISITED, 1);
+        STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(next));
+        for (const VertexId *n = CG.neighbors_begin(next); n != end; n++) {
+            if (not state.is_marked(*n)) {
+                state.mark_vertex(*n);
+                state.set_predecessor(*n, next);
+                
+                if (*n == dest) {
+                    return;
+                }
+                if (depth < limit) {
+                    frontier.push_back(*n);
+                }
+            }
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: bidirectionalBfs
+ * @purpose: finds a shortest path by growing breadth first frontiers from
+ *           both Artists, one whole level at a time, always expanding the
+ *           smaller frontier, until the frontiers meet
+ *
+ * @preconditions: the Artists to traverse between are valid and not excluded
+ * @postconditions: the predecessors from the source to the destination
+ *                  describe a shortest path, just like after bfs, or no
+ *                  path exists and the destination has no predecessor
+ *
+ * @parameters: ids of the Artists provided by input
+ *
+ * @notes: 1) the forward search marks vertices and sets predecessors as
+ *            bfs does. The backward search records, in successors, the
+ *            next vertex on the way to the destination; once the searches
+ *            meet, that chain is copied into the predecessors so printPath
+ *            and report_path can follow it
+ *         2) only the vertices in backFrontier ever have a successor, so
+ *            they are all that needs to be reset afterwards
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::bidirectionalBfs(VertexId source, VertexId dest) {
+    if (successors.size() != CG.vertex_count()) {
+        successors.assign(CG.vertex_count(), CollabGraph::NO_VERTEX);
+    }
+    frontier.clear();
+    backFrontier.clear();
+    
+    state.mark_vertex(source);
+    frontier.push_back(source);
+    successors[dest] = dest;
+    backFrontier.push_back(dest);
+    
+    // A path to oneself does not exist, so there is nothing to search for
+    VertexId meet = CollabGraph::NO_VERTEX;
+    size_t head = 0, backHead = 0;
+    
+    while (source != dest and meet == CollabGraph::NO_VERTEX and
+           head < frontier.size() and backHead < backFrontier.size()) {
+        if (frontier.size() - head <= backFrontier.size() - backHead) {
+            meet = expandForward(head);
+        }
+        else {
+            meet = expandBackward(source, backHead);
+        }
+    }
+    
+    // Link the backward half of the path onto the forward half
+    if (meet != CollabGraph::NO_VERTEX) {
+        for (VertexId v = meet; v != dest; v = successors[v]) {
+            state.set_predecessor(successors[v], v);
+        }
+    }
+    
+    for (size_t i = 0; i < backFrontier.size(); i++) {
+        successors[backFrontier[i]] = CollabGraph::NO_VERTEX;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: directionOptimizingBfs
+ * @purpose: finds a shortest path one whole level at a time, finding each
+ *           level top-down from the frontier or bottom-up from the
+ *           unvisited vertices, whichever should look at fewer edges
+ *
+ * @preconditions: the Artists to traverse between are valid and not excluded
+ * @postconditions: the predecessors from the source to the destination
+ *                  describe a shortest path, or no path exists and the
+ *                  destination has no predecessor
+ *
+ * @parameters: ids of the Artists provided by input
+ *
+ * @notes: the path has the same length as the one bfs finds, but when
+ *         several shortest paths exist it may be a different one, since a
+ *         bottom-up level gives each vertex the first neighbor it finds in
+ *         the frontier as its predecessor. Vertices excluded by not are
+ *         marked, so neither direction ever visits them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::directionOptimizingBfs(VertexId source, VertexId dest) {
+    size_t numVertices = CG.vertex_count();
+    if (inFrontier.size() != (numVertices + 63) / 64) {
+        inFrontier.assign((numVertices + 63) / 64, 0);
+    }
+    
+    uint64_t unexplored = CG.adjacency_size();
+    uint64_t frontierEdges = CG.neighbors_end(source) - 
+                             CG.neighbors_begin(source);
+    
+    frontier.clear();
+    state.mark_vertex(source);
+    frontier.push_back(source);
+    
+    // A path to oneself does not exist, so there is nothing to search for
+    if (source == dest) {
+        return;
+    }
+    
+    bool bottomUp = false;
+    size_t previous = 0;
+    
+    // Stop after the level that reaches the destination
+    while (not frontier.empty() and not state.is_marked(dest)) {
+        unexplored -= frontierEdges;
+        bottomUp = searchBottomUp(bottomUp, frontierEdges, unexplored, 
+                                  frontier.size(), previous, numVertices);
+        previous = frontier.size();
+        
+        if (bottomUp) {
+            bottomUpStep(frontierEdges);
+        }
+        else {
+            topDownStep(frontierEdges);
+        }
+        frontier.swap(nextLevel);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: topDownStep
+ * @purpose: finds the next level by visiting the neighbors of the frontier
+ *
+ * @preconditions: frontier holds the current level
+ * @postconditions: nextLevel holds the next level, which is visited and
+ *                  has predecessors
+ *
+ * @parameters: set to the number of edges of the next level
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::topDownStep(uint64_t &frontierEdges) {
+    nextLevel.clear();
+    frontierEdges = 0;
+    
+    for (size_t i = 0; i < frontier.size(); i++) {
+        const VertexId *end = CG.neighbors_end(frontier[i]);
+        STATS_COUNT(VERTICES_VISITED, 1);
+        STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(frontier[i]));
+        for (const VertexId *n = CG.neighbors_begin(frontier[i]); n != end; 
+             n++) {
+            if (not state.is_marked(*n)) {
+                state.mark_vertex(*n);
+                state.set_predecessor(*n, frontier[i]);
+                nextLevel.push_back(*n);
+                frontierEdges += CG.neighbors_end(*n) - CG.neighbors_begin(*n);
+            }
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: bottomUpStep
+ * @purpose: finds the next level by having every unvisited vertex look for
+ *           a neighbor in the frontier
+ *
+ * @preconditions: frontier holds the current level
+ * @postconditions: nextLevel holds the next level, which is visited and
+ *                  has predecessors
+ *
+ * @parameters: set to the number of edges of the next level
+ *
+ * @notes: the frontier is put in the inFrontier bitmap for the sweep and
+ *         taken out again afterwards, so the bitmap is always clear
+ *         between levels
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::bottomUpStep(uint64_t &frontierEdges) {
+    nextLevel.clear();
+    frontierEdges = 0;
+    
+    for (size_t i = 0; i < frontier.size(); i++) {
+        inFrontier[frontier[i] / 64] |= (uint64_t) 1 << (frontier[i] % 64);
+    }
+    
+    VertexId numVertices = CG.vertex_count();
+    for (VertexId v = 0; v < numVertices; v++) {
+        if (state.is_marked(v)) {
+            continue;
+        }
+        const VertexId *end = CG.neighbors_end(v);
+        const VertexId *n = CG.neighbors_begin(v);
+        for (; n != end; n++) {
+            if (inFrontier[*n / 64] & ((uint64_t) 1 << (*n % 64))) {
+                state.mark_vertex(v);
+                state.set_predecessor(v, *n);
+                nextLevel.push_back(v);
+                frontierEdges += end - CG.neighbors_begin(v);
+                break;
+            }
+        }
+        STATS_COUNT(VERTICES_VISITED, 1);
+        STATS_COUNT(EDGES_SCANNED, n - CG.neighbors_begin(v) + (n != end));
+    }
+    
+    for (size_t i = 0; i < frontier.size(); i++) {
+        inFrontier[frontier[i] / 64] = 0;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: expandForward
+ * @purpose: visits every neighbor of the forward search's current level
+ *
+ * @preconditions: the current level is frontier[head, frontier.size())
+ * @postconditions: the next level is appended to frontier, and head points
+ *                  to its start
+ *
+ * @parameters: the start of the current level
+ * @returns: the first vertex also reached by the backward search, or
+ *           NO_VERTEX if the searches have not met
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+TraversalEngine::VertexId TraversalEngine::expandForward(size_t &head) {
+    size_t levelEnd = frontier.size();
+    
+    for (; head < levelEnd; head++) {
+        VertexId next = frontier[head];
+        
+        const VertexId *end = CG.neighbors_end(next);
+        STATS_COUNT(VERTICES_VISITED, 1);
+        STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(next));
+        for (const VertexId *n = CG.neighbors_begin(next); n != end; n++) {
+            if (not state.is_marked(*n)) {
+                state.mark_vertex(*n);
+                state.set_predecessor(*n, next);
+                frontier.push_back(*n);
+                
+                if (successors[*n] != CollabGraph::NO_VERTEX) {
+                    return *n;
+                }
+            }
+        }
+    }
+    return CollabGraph::NO_VERTEX;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: expandBackward
+ * @purpose: visits every neighbor of the backward search's current level
+ *
+ * @preconditions: the current level is backFrontier[backHead, end)
+ * @postconditions: the next level is appended to backFrontier, and backHead
+ *                  points to its start
+ *
+ * @parameters: the id of the source Artist, and the start of the current
+ *              level
+ * @returns: the first vertex also reached by the forward search, or
+ *           NO_VERTEX if the searches have not met
+ *
+ * @notes: a marked vertex was either reached by the forward search (it is
+ *         the source or has a predecessor) or excluded by not, in which
+ *         case the backward search must avoid it too
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+TraversalEngine::VertexId TraversalEngine::expandBackward(VertexId source, 
+                                                         size_t &backHead) {
+    size_t levelEnd = backFrontier.size();
+    
+    for (; backHead < levelEnd; backHead++) {
+        VertexId next = backFrontier[backHead];
+        
+        const VertexId *end = CG.neighbors_end(next);
+        STATS_COUNT(VERTICES_VISITED, 1);
+        STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(next));
+        for (const VertexId *n = CG.neighbors_begin(next); n != end; n++) {
+            if (successors[*n] != CollabGraph::NO_VERTEX) {
+                continue;
+            }
+            
+            bool reached = state.is_marked(*n);
+            if (reached and *n != source and 
+                state.get_predecessor(*n) == CollabGraph::NO_VERTEX) {
+                continue; // excluded
+            }
+            
+            successors[*n] = next;
+            backFrontier.push_back(*n);
+            
+            if (reached) {
+                return *n;
+            }
+        }
+    }
+    return CollabGraph::NO_VERTEX;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: notWrapper
+ * @purpose: marks excluded Artists as seen to avoid them in traversal then
+ *           does a breadth first traversal of the graph
+ *
+ * @preconditions: none
+ * @postconditions: predecessors for all visited nodes are set or error
+ *                  message is printed
+ *
+ * @parameters: ids of the Artists provided by input, the query holding the
+ *              Artists to exclude, and output stream for printing error
+ *              messages
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::notWrapper(VertexId source, VertexId dest, 
+                                 const Query &query, ResultWriter &output) {
+    invalidExcludes.clear();
+    
+    // Mark Artists to exclude as seen, to avoid them during traversal
+    for (size_t i = 0; i < query.numExcluded; i++) {
+        VertexId excluded = CG.get_vertex_id(query.excluded[i]);
+        // Cannot access invalid vertices, so we add them to a list of invalids
+        if (excluded == CollabGraph::NO_VERTEX) {
+            invalidExcludes.push_back(i);
+        }
+        else {
+            state.mark_vertex(excluded);
+        }
+    }
+    // Now that all not specific processes are done, call BFS
+    bfsWrapper(source, dest, query, output);
+    
+    // If there were invalid Artists print error messages
+    for (size_t i = 0; i < invalidExcludes.size(); i++) {
+        errorMessage(query.excluded[invalidExcludes[i]], output);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: dfsWrapper
+ * @purpose: checks if Artists to traverse between are valid, and not in
+ *           the query's exclusion set
+ *
+ * @preconditions: none
+ * @postconditions: error message is printed or traversal begins
+ *
+ * @parameters: ids of the Artists provided by input (NO_VERTEX if not in
+ *              the graph), the query, and where to print error message to
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::dfsWrapper(VertexId source, VertexId dest, 
+                                 const Query &query, ResultWriter &output) {
+    // Check if Artists are vertices in the graph
+    if (not validArtists(source, dest, query, output)) {
+        return;
+    }
+    
+    // If either of the Artists are in the query's exclusion set, stop
+    else if (state.is_marked(source) or state.is_marked(dest)) {
+        return;
+    }
+    
+    // If conditions are good, call the traversal function
+    dfs(source, dest);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: dfs
+ * @purpose: traverses by visiting nodes along the deepest path possible
+ *
+ * @preconditions: the Artists to traverse between are valid
+ * @postconditions: predecessors for all visited nodes are set or error
+ *                  message is printed
+ *
+ * @parameters: ids of the Artists provided by input
+ *
+ * @notes: the frontier vector is used as the stack. As it always has, the
+ *         pop after the neighbors are pushed removes the newest neighbor
+ *         (or the vertex itself, if nothing was pushed), which decides the
+ *         order vertices are visited in and so the path that is printed
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::dfs(VertexId source, VertexId dest) {
+    frontier.clear();
+    
+    state.mark_vertex(source); 
+    frontier.push_back(source);
+   
+   // Visit vertices until destination is reached or whole graph is traversed
+    while (not frontier.empty()) {
+        VertexId next = frontier.back();
+        
+        // If we have reached the destination, nothing else is needed
+        if (next == dest) {
+            return;
+        }
+        
+        // Update information for all unvisited neighbors
+        const VertexId *end = CG.neighbors_end(next);
+        STATS_COUNT(VERTICES_VISITED, 1);
+        STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(next));
+        for (const VertexId *n = CG.neighbors_begin(next); n != end; n++) {
+            if (not state.is_marked(*n)) {
+               state.mark_vertex(*n);
+               state.set_predecessor(*n, next);
+               frontier.push_back(*n);
+           }
+        }
+        frontier.pop_back();
+    }  
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: inclWrapper
+ * @purpose: checks if the Artists and what the path must pass through are
+ *           valid, and if so finds and prints the shortest such path
+ *
+ * @preconditions: the search state has been cleared
+ * @postconditions: the path, that none exists, or error messages are
+ *                  printed
+ *
+ * @parameters: ids of the Artists provided by input (NO_VERTEX if not in
+ *              the graph), the query, and where to print output to
+ *
+ * @notes: what to pass through is an Artist if the graph has one by that
+ *         name, and a song otherwise, so the path must then use a
+ *         collaboration between two Artists who both have the song
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::inclWrapper(VertexId source, VertexId dest, 
+                                  const Query &query, ResultWriter &output) {
+    // Check if Artists are vertices in the graph
+    bool valid = validArtists(source, dest, query, output);
+    
+    VertexId artist = CG.get_vertex_id(query.through);
+    bool bySong = (artist == CollabGraph::NO_VERTEX);
+    if (bySong and not CG.get_song_artists(query.through, songArtists)) {
+        errorMessage(query.through, output);
+        return;
+    }
+    if (not valid) {
+        return;
+    }
+    
+    // A landmark that reaches only one end of a path the search needs
+    // proves there is none, without searching
+    uint32_t lower, upper;
+    VertexId middle = bySong ? source : artist;
+    bool found = false;
+    if (source != dest and CG.distance_bounds(source, middle, lower, upper)
+        and CG.distance_bounds(middle, dest, lower, upper)) {
+        size_t words = (CG.vertex_count() + 63) / 64;
+        if (crossed.size() != words) {
+            crossed.assign(words, 0);
+            onSong.assign(words, 0);
+        }
+        for (VertexId v : songArtists) {
+            onSong[v / 64] |= (uint64_t) 1 << (v % 64);
+        }
+        
+        passed.clear(CG.vertex_count());
+        crossings.clear();
+        found = inclBfs(source, dest, artist);
+        
+        if (found) {
+            printIncl(dest, query, bySong, output);
+        }
+        
+        // Only the listed vertices have bits to reset
+        for (VertexId v : crossings) {
+            crossed[v / 64] = 0;
+        }
+        for (VertexId v : songArtists) {
+            onSong[v / 64] = 0;
+        }
+    }
+    songArtists.clear();
+    
+    if (not found) {
+        STATS_TIMER(OUTPUT);
+        output.noPath(query.source, query.dest);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: inclBfs
+ * @purpose: finds a shortest path that passes through an Artist, or uses a
+ *           collaboration on a song, by searching two layers of the graph
+ *           at once, one whole level at a time
+ *
+ * @preconditions: the Artists are valid and different, the search state
+ *                 and passed have been cleared, crossings is empty, and
+ *                 onSong has a bit set for each of songArtists
+ * @postconditions: the predecessors from the source to the destination,
+ *                  through state and then passed, describe a shortest
+ *                  path, and crossed has a bit set for each of crossings
+ *
+ * @parameters: ids of the Artists provided by input, and of the Artist to
+ *              pass through (NO_VERTEX to use the song instead)
+ * @returns: true iff such a path exists
+ *
+ * @notes: 1) a walk is in the first layer (marked in state) until it has
+ *            met the condition, and in the second (marked in passed) after,
+ *            so it crosses over on reaching the Artist, or on going between
+ *            two of the song's Artists. The destination is only reached
+ *            once it is found in the second layer. Walks may go through an
+ *            Artist twice, once in each layer, exactly as a search to the
+ *            Artist followed by one from it may
+ *         2) the first layer is only searched while it can still cross
+ *            over: until the Artist is reached, or until every one of the
+ *            song's Artists it reaches has been expanded. From then on, the
+ *            search is a plain bfs of the second layer, so passing through
+ *            an Artist costs no more than the two searches it replaces
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TraversalEngine::inclBfs(VertexId source, VertexId dest, 
+                              VertexId artist) {
+    frontier.clear();
+    backFrontier.clear();
+    
+    // Starting at the Artist to pass through already meets the condition
+    if (source == artist) {
+        passed.mark_vertex(source);
+        backFrontier.push_back(source);
+    }
+    else {
+        state.mark_vertex(source);
+        frontier.push_back(source);
+    }
+    
+    // How many more vertices the first layer can cross over from
+    size_t crossable = artist != CollabGraph::NO_VERTEX ? 1 
+                                                        : songArtists.size();
+    
+    size_t head = 0, backHead = 0;
+    while ((crossable > 0 and head < frontier.size()) or 
+           backHead < backFrontier.size()) {
+        // The second layer's level goes first, so what the first layer
+        // crosses over to joins the level after it, like the rest it finds
+        size_t levelEnd = backFrontier.size();
+        for (; backHead < levelEnd; backHead++) {
+            VertexId next = backFrontier[backHead];
+            const VertexId *end = CG.neighbors_end(next);
+            STATS_COUNT(VERTICES_VISITED, 1);
+            STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(next));
+            for (const VertexId *n = CG.neighbors_begin(next); n != end; 
+                 n++) {
+                if (not passed.is_marked(*n)) {
+                    passed.mark_vertex(*n);
+                    passed.set_predecessor(*n, next);
+                    if (*n == dest) {
+                        return true;
+                    }
+                    backFrontier.push_back(*n);
+                }
+            }
+        }
+        
+        levelEnd = frontier.size();
+        for (; crossable > 0 and head < levelEnd; head++) {
+            VertexId next = frontier[head];
+            bool onBoth = artist == CollabGraph::NO_VERTEX and 
+                          (onSong[next / 64] >> (next % 64) & 1);
+            if (onBoth) {
+                crossable--;
+            }
+            
+            const VertexId *end = CG.neighbors_end(next);
+            STATS_COUNT(VERTICES_VISITED, 1);
+            STATS_COUNT(EDGES_SCANNED, end - CG.neighbors_begin(next));
+            for (const VertexId *n = CG.neighbors_begin(next); n != end; 
+                 n++) {
+                bool crosses = onBoth ? (onSong[*n / 64] >> (*n % 64) & 1)
+                                      : *n == artist;
+                if (crosses and not passed.is_marked(*n)) {
+                    passed.mark_vertex(*n);
+                    passed.set_predecessor(*n, next);
+                    crossed[*n / 64] |= (uint64_t) 1 << (*n % 64);
+                    crossings.push_back(*n);
+                    if (*n == dest) {
+                        return true;
+                    }
+                    backFrontier.push_back(*n);
+                    
+                    // The Artist is only passed through once
+                    if (artist != CollabGraph::NO_VERTEX) {
+                        crossable = 0;
+                        break;
+                    }
+                }
+                if (not state.is_marked(*n)) {
+                    state.mark_vertex(*n);
+                    state.set_predecessor(*n, next);
+                    frontier.push_back(*n);
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: degrees
+ * @purpose: estimates how many degrees apart two Artists are from the
+ *           landmark distances alone, without searching
+ *
+ * @preconditions: none
+ * @postconditions: the bounds on their distance, or that no path exists,
+ *                  or an error message is printed
+ *
+ * @parameters: ids of the Artists provided by input (NO_VERTEX if not in
+ *              the graph), the query holding their names, and where to
+ *              print output to
+ *
+ * @notes: the bounds are exact when they match; with no landmarks, all
+ *         that is known is that two different Artists are at least 1 apart
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::degrees(VertexId source, VertexId dest, 
+                              const Query &query, ResultWriter &output) {
+    if (not validArtists(source, dest, query, output)) {
+        return;
+    }
+    
+    // As with bfs, an Artist has no path to themself
+    uint32_t lower, upper;
+    if (source == dest or not CG.distance_bounds(source, dest, lower, upper)) {
+        output.noPath(query.source, query.dest);
+        return;
+    }
+    
+    output.degrees(query.source, query.dest, lower, upper);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: validArtists
+ * @purpose: ensures that the Artists we want to use for traversal are 
+ *           valid vertices
+ *
+ * @preconditions: none
+ * @postconditions: if provided Artists are not in the graph, an error message
+ *                  will print and the traversal function will not run 
+ *
+ * @parameters: ids of the Artists provided by input, the query holding their
+ *              names, and where to print error message to
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TraversalEngine::validArtists(VertexId source, VertexId dest, 
+                                   const Query &query, ResultWriter &output) {
+    // Print error messages for any invalid vertices
+    if (source == CollabGraph::NO_VERTEX) {
+        errorMessage(query.source, output);
+    }
+    if (dest == CollabGraph::NO_VERTEX) {
+        errorMessage(query.dest, output);
+    }
+    return source != CollabGraph::NO_VERTEX and 
+           dest != CollabGraph::NO_VERTEX;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: errorMessage
+ * @purpose: print the appropriate error message when an Artist doesn't exist
+ *
+ * @preconditions: the Artist is not in the graph
+ * @postconditions: none
+ *
+ * @parameters: an Artist's name provided by input and where to print error
+ *              message to
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::errorMessage(const string &name, 
+                                   ResultWriter &output) {
+    STATS_TIMER(OUTPUT);
+    output.notFound(name);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: printPath
+ * @purpose: prints the path between two Artists
+ *
+ * @preconditions: there is a valid path between the two artists
+ * @postconditions: none
+ *
+ * @parameters: ids of the Artists provided by input, the query holding their
+ *              names, and where to print output to
+ *
+ * @notes: follows the predecessors the same way CollabGraph::report_path
+ *         does, collecting them into the reusable path buffer (destination
+ *         first)
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::printPath(VertexId source, VertexId dest, 
+                                const Query &query, ResultWriter &output) {
+    STATS_TIMER(OUTPUT);
+    
+    // Only get the path from valid vertices, avoid accessing invalid space
+    if (source == CollabGraph::NO_VERTEX or dest == CollabGraph::NO_VERTEX) {
+        return;
+    }
+    
+    path.clear();
+    
+    // Cannot have a path to self, and no predecessor means no path
+    VertexId curr = dest;
+    while (source != dest and curr != source and 
+           curr != CollabGraph::NO_VERTEX) {
+        path.push_back(curr);
+        curr = state.get_predecessor(curr);
+    }
+    
+    if (source == dest or curr == CollabGraph::NO_VERTEX) {
+        output.noPath(query.source, query.dest);
+        return;
+    }
+    
+    // Print each collaboration along the path
+    output.beginPath();
+    for (size_t i = path.size(); i > 0; i--) {
+        VertexId next = path[i - 1];
+        string_view song;
+        CG.get_edge_view(curr, next, song);
+        
+        output.step(curr, CG.get_vertex_name(curr), next, 
+                    CG.get_vertex_name(next), song);
+        
+        curr = next;
+    }
+    output.endPath();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: printIncl
+ * @purpose: prints the path an incl query found
+ *
+ * @preconditions: inclBfs found a path between the two Artists
+ * @postconditions: none
+ *
+ * @parameters: the id of the destination Artist, the query, whether the
+ *              path had to use a song, and where to print output to
+ *
+ * @notes: the predecessors are followed through passed until the vertex
+ *         the path crossed over at, and through state from there; each
+ *         layer's first vertex is the only one without a predecessor. The
+ *         collaboration crossed on is printed with the query's song, which
+ *         both Artists have even if their edge is named by another
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TraversalEngine::printIncl(VertexId dest, const Query &query, 
+                                bool bySong, ResultWriter &output) {
+    STATS_TIMER(OUTPUT);
+    
+    path.clear();
+    
+    VertexId curr = dest;
+    bool second = true;
+    size_t crossing = path.max_size();
+    while (true) {
+        VertexId prev = second ? passed.get_predecessor(curr) 
+                               : state.get_predecessor(curr);
+        if (prev == CollabGraph::NO_VERTEX) {
+            break;
+        }
+        path.push_back(curr);
+        if (second and (crossed[curr / 64] >> (curr % 64) & 1)) {
+            second = false;
+            crossing = path.size() - 1;
+        }
+        curr = prev;
+    }
+    
+    // Print each collaboration along the path
+    output.beginPath();
+    for (size_t i = path.size(); i > 0; i--) {
+        VertexId next = path[i - 1];
+        string_view song = query.through;
+        if (not bySong or i - 1 != crossing) {
+            CG.get_edge_view(curr, next, song);
+        }
+        
+        output.step(curr, CG.get_vertex_name(curr), next, 
+                    CG.get_vertex_name(next), song);
+        
+        curr = next;
+    }
+    output.endPath();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: countDistances
+ * @purpose: finds how many hops every artist is from the source, one whole
+ *           level at a time, choosing for each level whether to search it
+ *           top-down or bottom-up
+ *
+ * @preconditions: source is a vertex of the graph
+ * @postconditions: counts[d] has grown by the number of artists d hops
+ *                  from the source (counts is grown if needed)
+ *
+ * @parameters: the id of the source Artist, the counts to add to, and how
+ *              many threads to search each level with
+ * @returns: the source's eccentricity, the greatest distance from it to
+ *           any artist it is connected to
+ *
+ * @notes: a top-down level visits the neighbors of every vertex in the
+ *         frontier; a bottom-up level instead has every unreached vertex
+ *         look for a neighbor in the frontier, stopping at the first one.
+ *         Once the frontier touches a large part of the remaining edges,
+ *         bottom-up looks at far fewer of them
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t TraversalEngine::countDistances(VertexId source, 
+                                       vector<uint64_t> &counts,
+                                       unsigned numThreads) {
+    STATS_TIMER(TRAVERSE);
+    
+    size_t numVertices = CG.vertex_count();
+    if (depth.size() != numVertices) {
+        vector<atomic<uint32_t>>(numVertices).swap(depth);
+    }
+    for (size_t v = 0; v < numVertices; v++) {
+        depth[v].store(UNREACHED, memory_order_relaxed);
+    }
+    nextParts.resize(max(numThreads, 1u));
+    edgeParts.resize(nextParts.size());
+    
+    uint64_t unexplored = CG.adjacency_size();
+    uint64_t frontierEdges = CG.neighbors_end(source) - 
+                             CG.neighbors_begin(source);
+    
+    frontier.clear();
+    frontier.push_back(source);
+    depth[source].store(0, memory_order_relaxed);
+    
+    uint32_t level = 0;
+    bool bottomUp = false;
+    size_t previous = 0;
+    
+    while (true) {
+        if (counts.size() <= level) {
+            counts.resize(level + 1, 0);
+        }
+        counts[level] += frontier.size();
+        unexplored -= frontierEdges;
+        
+        bottomUp = searchBottomUp(bottomUp, frontierEdges, unexplored, 
+                                  frontier.size(), previous, numVertices);
+        previous = frontier.size();
+        
+        if (bottomUp) {
+            frontierEdges = bottomUpLevel(level, numThreads);
+        }
+        else {
+            frontierEdges = topDownLevel(level, numThreads);
+        }
+        
+        if (frontier.empty()) {
+            return level;
+        }
+        level++;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: topDownLevel
+ * @purpose: finds the next level by visiting the neighbors of the frontier
+ *
+ * @preconditions: frontier holds every vertex at depth level
+ * @postconditions: frontier holds every vertex at depth level + 1
+ *
+ * @parameters: the depth of the frontier, and how many threads to use
+ * @returns: the number of edges of the new frontier
+ *
+ * @notes: threads claim a vertex by swapping its depth from UNREACHED, so
+ *         each vertex is added to the next level exactly once
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t TraversalEngine::topDownLevel(uint32_t level, unsigned numThreads) {
+    size_t numTasks = (frontier.size() + CHUNK - 1) / CHUNK;
+    
+    runTasks(numThreads, numTasks, [&](unsigned t, size_t task) {
+        size_t end = min(frontier.size(), (task + 1) * CHUNK);
+        for (size_t i = task * CHUNK; i < end; i++) {
+            const VertexId *last = CG.neighbors_end(frontier[i]);
+            STATS_COUNT(VERTICES_VISITED, 1);
+            STATS_COUNT(EDGES_SCANNED, last - CG.neighbors_begin(frontier[i]));
+            for (const VertexId *n = CG.neighbors_begin(frontier[i]); 
+                 n != last; n++) {
+                uint32_t unreached = UNREACHED;
+                if (depth[*n].load(memory_order_relaxed) == UNREACHED and
+                    depth[*n].compare_exchange_strong(
+                        unreached, level + 1, memory_order_relaxed)) {
+                    nextParts[t].push_back(*n);
+                    edgeParts[t] += CG.neighbors_end(*n) - 
+                                    CG.neighbors_begin(*n);
+                }
+            }
+        }
+    });
+    return gatherLevel();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: bottomUpLevel
+ * @purpose: finds the next level by having every unreached vertex look for
+ *           a neighbor in the frontier
+ *
+ * @preconditions: every vertex at depth level has been reached, and no
+ *                 deeper vertex has
+ * @postconditions: frontier holds every vertex at depth level + 1
+ *
+ * @parameters: the depth of the frontier, and how many threads to use
+ * @returns: the number of edges of the new frontier
+ *
+ * @notes: each thread only sets the depth of the vertices in its own
+ *         chunks, and a depth of level + 1 is never mistaken for level, so
+ *         the threads need no coordination
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t TraversalEngine::bottomUpLevel(uint32_t level, unsigned numThreads) {
+    size_t numVertices = CG.vertex_count();
+    size_t numTasks = (numVertices + CHUNK - 1) / CHUNK;
+    
+    runTasks(numThreads, numTasks, [&](unsigned t, size_t task) {
+        VertexId end = min(numVertices, (task + 1) * CHUNK);
+        for (VertexId v = task * CHUNK; v < end; v++) {
+            if (depth[v].load(memory_order_relaxed) != UNREACHED) {
+                continue;
+            }
+            const VertexId *last = CG.neighbors_end(v);
+            const VertexId *n = CG.neighbors_begin(v);
+            for (; n != last; n++) {
+                if (depth[*n].load(memory_order_relaxed) == level) {
+                    depth[v].store(level + 1, memory_order_relaxed);
+                    nextParts[t].push_back(v);
+                    edgeParts[t] += last - CG.neighbors_begin(v);
+                    break;
+                }
+            }
+            STATS_COUNT(VERTICES_VISITED, 1);
+            STATS_COUNT(EDGES_SCANNED, 
+                        n - CG.neighbors_begin(v) + (n != last));
+        }
+    });
+    return gatherLevel();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: gatherLevel
+ * @purpose: makes the parts of the next level found by each thread the
+ *           new frontier
+ *
+ * @preconditions: nextParts and edgeParts hold what each thread found
+ * @postconditions: frontier is the next level, and the parts are empty
+ *
+ * @parameters: none
+ * @returns: the number of edges of the new frontier
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint64_t TraversalEngine::gatherLevel() {
+    frontier.clear();
+    uint64_t edges = 0;
+    
+    for (size_t t = 0; t < nextParts.size(); t++) {
+        frontier.insert(frontier.end(), nextParts[t].begin(), 
+                        nextParts[t].end());
+        nextParts[t].clear();
+        edges += edgeParts[t];
+        edgeParts[t] = 0;
+    }
+    return edges;
+}
@@ -0,0 +1,177 @@
+/*
+ * TraversalEngine.h
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Interface for TraversalEngine. A TraversalEngine answers bfs, dfs, not,
+ * bibfs, binot, bfs-many, incl and degrees queries against a frozen
+ * CollabGraph
+ * that it only reads, and counts how far artists are from one another.
+ * All of the state a query needs (visited marks, predecessors, frontiers)
+ * belongs to the engine, so several engines, one per thread, can answer
+ * queries against the same graph at the same time.
+ *
+ */
+
+#ifndef _TRAVERSAL_ENGINE_H_
+#define _TRAVERSAL_ENGINE_H_
+
+#include "CollabGraph.h"
+#include "ResultWriter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Named sets of artists that bfs, dfs, not, bibfs and binot can exclude,
+// each a bitmap with a bit for every VertexId of the graph
+typedef unordered_map<string, vector<uint64_t>> ExclusionSets;
+
+// One traversal command and the input lines that go with it
+struct Query {
+    string command;
+    string source;
+    string dest;
+    
+    // The exclusion set named after the command, if any
+    string exclusionSet;
+
+    // Names given to not/binot; only the first numExcluded are this query's,
+    // the rest are kept so their strings can be reused
+    vector<string> excluded;
+    size_t numExcluded = 0;
+    
+    // Destinations given to bfs-many, kept for reuse the same way
+    vector<string> targets;
+    size_t numTargets = 0;
+    
+    // The artist or song an incl path must pass through
+    string through;
+};
+
+class TraversalEngine {
+
+public:
+    // Constructor, which takes the (frozen) graph to answer queries on
+    TraversalEngine(const CollabGraph &graph);
+    
+    // Chooses whether bfs and not use the direction-optimizing search
+    void setDirectionOptimizing(bool use);
+    
+    // Gives the exclusion sets that queries can name, which must not
+    // change while a query runs
+    void setExclusionSets(const ExclusionSets *sets);
+
+    // Answers one traversal query, writing its result to output, or
+    // printing it as text to a stream
+    void run(const Query &query, ResultWriter &output);
+    void run(const Query &query, ostream &output);
+    
+    // How many artists the last bfs, not, bibfs or binot query queued,
+    // from either end, when neither landmarks nor the direction-optimizing
+    // search cut its queue short
+    size_t verticesReached() const;
+    
+    // Adds the number of artists at each distance from source to counts,
+    // searching on numThreads threads, and returns source's eccentricity
+    size_t countDistances(CollabGraph::VertexId source, 
+                          vector<uint64_t> &counts, unsigned numThreads);
+
+private:
+    typedef CollabGraph::VertexId VertexId;
+
+    // The graph being searched, which is never modified
+    const CollabGraph &CG;
+
+    // Visited marks and predecessors of the current query
+    CollabGraph::SearchState state;
+
+    // Whether the current bfs/not query searches from both ends (bibfs/binot)
+    bool bidirectional = false;
+    
+    // Whether bfs and not search level by level, top-down or bottom-up
+    bool directionOptimizing = false;
+    
+    // The exclusion sets queries can name, if any were given
+    const ExclusionSets *exclusionSets = nullptr;
+
+    // Traversal functions, which work on the ids of the Artists
+    void bfs(VertexId source, VertexId dest);
+    void landmarkBfs(VertexId source, VertexId dest, uint32_t limit);
+    void dfs(VertexId source, VertexId dest);
+    void bidirectionalBfs(VertexId source, VertexId dest);
+    void directionOptimizingBfs(VertexId source, VertexId dest);
+    void topDownStep(uint64_t &frontierEdges);
+    void bottomUpStep(uint64_t &frontierEdges);
+    VertexId expandForward(size_t &head);
+    VertexId expandBackward(VertexId source, size_t &backHead);
+    void bfsWrapper(VertexId source, VertexId dest, const Query &query,
+                    ResultWriter &output);
+    void bfsMany(const Query &query, ResultWriter &output);
+    uint64_t topDownLevel(uint32_t level, unsigned numThreads);
+    uint64_t bottomUpLevel(uint32_t level, unsigned numThreads);
+    uint64_t gatherLevel();
+    void dfsWrapper(VertexId source, VertexId dest, const Query &query,
+                    ResultWriter &output);
+    void notWrapper(VertexId source, VertexId dest, const Query &query,
+                    ResultWriter &output);
+    void degrees(VertexId source, VertexId dest, const Query &query,
+                 ResultWriter &output);
+    void inclWrapper(VertexId source, VertexId dest, const Query &query,
+                     ResultWriter &output);
+    bool inclBfs(VertexId source, VertexId dest, VertexId artist);
+
+    // Helper functions to ensure Artist exists in the CollabGraph
+    void errorMessage(const string &name, ResultWriter &output);
+    bool validArtists(VertexId source, VertexId dest, const Query &query,
+                      ResultWriter &output);
+
+    // Helper function that prints path from traversal
+    void printPath(VertexId source, VertexId dest, const Query &query,
+                   ResultWriter &output);
+    void printIncl(VertexId dest, const Query &query, bool bySong,
+                   ResultWriter &output);
+
+    // Where a query run on a stream is formatted, before it is printed
+    ResultWriter buffered;
+    
+    // Buffers reused by every query, so they only allocate while growing
+    vector<size_t> invalidExcludes;
+    vector<VertexId> frontier;
+    vector<VertexId> backFrontier;
+    vector<VertexId> successors;
+    vector<VertexId> path;
+    
+    // The source and one destination of a bfs-many, as a bfs query
+    Query single;
+    
+    // Distance of every vertex from the source of countDistances, and the
+    // next level as found by each thread, with the degrees of its vertices
+    vector<atomic<uint32_t>> depth;
+    vector<vector<VertexId>> nextParts;
+    vector<uint64_t> edgeParts;
+    
+    // The level after the frontier, and a bitmap of the frontier's vertices,
+    // for the direction-optimizing bfs
+    vector<VertexId> nextLevel;
+    vector<uint64_t> inFrontier;
+    
+    // The second layer of an incl search, holding the walks that have met
+    // its condition: their marks and predecessors, a bitmap of the vertices
+    // it was entered at from the first layer, and a bitmap of the artists
+    // of the song the walks must use, with lists to reset both by
+    CollabGraph::SearchState passed;
+    vector<uint64_t> crossed;
+    vector<VertexId> crossings;
+    vector<uint64_t> onSong;
+    vector<VertexId> songArtists;
+};
+
+#endif /* _TRAVERSAL_ENGINE_H_ */
@@ -0,0 +1,180 @@
+/*
+ * UpdateBench.cpp
+ *
+ * CS15 Six Degrees
+ *
+ * Project 2
+ *
+ * Compares absorbing a delta of new artists and songs into a frozen graph
+ * with add_artist and add_song against rebuilding the graph from all of
+ * the data. The data is generated: half of the songs are new, and the rest
+ * repeat an earlier song, a few of them picked in proportion to how often
+ * it has been listed so far, so some songs are listed by many artists, as
+ * in real catalogs. The last artists are held back as the delta, along
+ * with the last song of some of the earlier ones. Afterwards, the same
+ * random bfs queries, each to one of the new artists, are answered on the
+ * updated graph and the rebuilt one, and their outputs should be
+ * identical.
+ *
+ * Usage: UpdateBench [artists] [songs per artist] [new artists] [queries]
+ *
+ */
+
+#include "CollabGraph.h"
+#include "TraversalEngine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: milliseconds
+ * @purpose: measures the time since start
+ *
+ * @parameters: the start time
+ * @returns: the elapsed time in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double milliseconds(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: build
+ * @purpose: builds a frozen graph from the first artists of the data, the
+ *           way SixDegrees reads a data file
+ *
+ * @parameters: the graph, every artist's name and songs, how many artists
+ *              to build from, and how many of each one's songs to leave out
+ * @returns: the time taken in milliseconds
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static double build(CollabGraph &graph, const vector<string> &names,
+                    const vector<vector<string_view>> &songs, size_t count,
+                    const vector<size_t> &held) {
+    Clock::time_point start = Clock::now();
+    CollabGraph::Builder builder(graph);
+    vector<string_view> list;
+
+    for (size_t a = 0; a < count; a++) {
+        list.assign(songs[a].begin(), songs[a].end() - held[a]);
+        builder.add_artist(names[a], list);
+    }
+    builder.finish();
+    return milliseconds(start);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: answer
+ * @purpose: answers every query with one engine
+ *
+ * @parameters: the graph and the queries
+ * @returns: the output of every query
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static string answer(const CollabGraph &graph, const vector<Query> &queries) {
+    TraversalEngine engine(graph);
+    ostringstream output;
+    for (const Query &query : queries) {
+        engine.run(query, output);
+    }
+    return output.str();
+}
+
+int main(int argc, char *argv[]) {
+    size_t numArtists = argc > 1 ? atol(argv[1]) : 200000;
+    size_t perArtist  = argc > 2 ? atol(argv[2]) : 10;
+    size_t numNew     = argc > 3 ? atol(argv[3]) : 1000;
+    size_t numQueries = argc > 4 ? atol(argv[4]) : 200;
+
+    if (numArtists <= numNew or perArtist < 2 or numQueries < 1) {
+        cerr << "Usage: UpdateBench [artists] [songs per artist]"
+             << " [new artists] [queries]\n";
+        return EXIT_FAILURE;
+    }
+
+    // Songs are stored once; each artist's list refers to them
+    mt19937 random(15);
+    vector<string> names(numArtists), catalog;
+    vector<size_t> listed;
+    vector<vector<string_view>> songs(numArtists);
+    catalog.reserve(numArtists * perArtist);
+    for (size_t a = 0; a < numArtists; a++) {
+        names[a] = "Artist " + to_string(a);
+        for (size_t s = 0; s < perArtist; s++) {
+            size_t pick = random() % 10;
+            if (listed.empty() or pick < 5) {
+                listed.push_back(catalog.size());
+                catalog.push_back("Song " + to_string(catalog.size()));
+            }
+            else if (pick == 5) {
+                listed.push_back(listed[random() % listed.size()]);
+            }
+            else {
+                listed.push_back(random() % catalog.size());
+            }
+        }
+    }
+    for (size_t a = 0, next = 0; a < numArtists; a++) {
+        for (size_t s = 0; s < perArtist; s++) {
+            songs[a].push_back(catalog[listed[next++]]);
+        }
+    }
+
+    // Every 20th earlier artist gets its last song in the delta
+    size_t numOld = numArtists - numNew, numSongs = 0;
+    vector<size_t> held(numArtists, 0), none(numArtists, 0);
+    for (size_t a = 0; a < numOld; a += 20) {
+        held[a] = 1;
+        numSongs++;
+    }
+
+    CollabGraph rebuilt, updated;
+    double rebuildMs = build(rebuilt, names, songs, numArtists, none);
+    double baseMs = build(updated, names, songs, numOld, held);
+
+    Clock::time_point start = Clock::now();
+    for (size_t a = numOld; a < numArtists; a++) {
+        updated.add_artist(names[a], songs[a]);
+    }
+    double artistMs = milliseconds(start);
+
+    start = Clock::now();
+    for (size_t a = 0; a < numOld; a++) {
+        if (held[a] != 0) {
+            updated.add_song(names[a], songs[a].back());
+        }
+    }
+    double songMs = milliseconds(start);
+
+    vector<Query> queries(numQueries);
+    for (size_t q = 0; q < numQueries; q++) {
+        queries[q].command = "bfs";
+        queries[q].source  = names[random() % numArtists];
+        queries[q].dest    = names[numOld + random() % numNew];
+    }
+    bool same = answer(updated, queries) == answer(rebuilt, queries);
+
+    cout << "data: " << numArtists << " artists, " << catalog.size()
+         << " distinct songs, " << rebuilt.get_build_stats().edges
+         << " collaborations\n"
+         << "rebuild from all of the data: " << rebuildMs << " ms\n"
+         << "build without the delta:      " << baseMs << " ms\n"
+         << "add_artist, " << numNew << " artists: " << artistMs << " ms ("
+         << artistMs * 1000 / numNew << " us each)\n"
+         << "add_song, " << numSongs << " songs:   " << songMs << " ms ("
+         << songMs * 1000 / numSongs << " us each)\n"
+         << "memory, rebuilt / updated:    "
+         << rebuilt.memory_footprint() / 1e6 << " / "
+         << updated.memory_footprint() / 1e6 << " MB\n"
+         << "same output on " << numQueries << " bfs queries: "
+         << (same ? "yes" : "no") << "\n";
+
+    return EXIT_SUCCESS;
+}
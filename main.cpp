@@ -12,7 +12,7 @@ using namespace std;
 
 int main(int argc, char *argv[])
 {
-    SixDegrees program = SixDegrees(argc, argv);
+    SixDegrees program(argc, argv);
     
     program.run();
     